@@ -1,19 +1,186 @@
 #include <iostream>
 #include <string>
 #include <map>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 #include <ctime>
+#include <chrono>
 #include <cctype>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <cstddef>
+#include <memory>
 #include <termios.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <ftw.h>
 using namespace std;
 
-const int MAX_ORDERS = 60;
+const int JOURNAL_COMPACT_THRESHOLD = 1000;  // minimum journal records before compaction
+const size_t MAX_TICKET_LINES = 32;          // line items on one order
+const int MAX_MENU_ID = 9999;                // menu item IDs index a dense lookup table
+const size_t KITCHEN_FEED_CAPACITY = 1024;   // kitchen events buffered for the display
+const size_t DEFAULT_MEMORY_BUDGET_MB = 256; // override with ORDER_MEMORY_BUDGET_MB
+const size_t ARENA_BLOCK_BYTES = 64 * 1024;  // arenas grow in blocks of this size
+const size_t INLINE_TICKET_LINES = 2;        // line items stored inside the order record
+const size_t LOAD_CHUNK_BYTES = 1 << 20;     // smallest file slice worth a loader thread
+const int DEFAULT_METRICS_INTERVAL = 60;     // seconds between metrics.prom writes; ORDER_METRICS_INTERVAL
+const int DEFAULT_COMMIT_WINDOW_US = 2000;   // longest a journal batch waits for more tills; ORDER_COMMIT_WINDOW_US
+const size_t MAX_REQUEST_LINE = 4096;        // longest till request; longer ones drop the connection
+
+// Heap bytes owned by a string, zero when it fits in the small-string buffer.
+size_t stringHeapBytes(const string& s) {
+    const char* p = s.data();
+    const char* self = reinterpret_cast<const char*>(&s);
+    if (p >= self && p < self + sizeof(string)) return 0;
+    return s.capacity() + 1;
+}
+
+// Bump allocator for data that lives as long as its owner. Memory is carved
+// from ARENA_BLOCK_BYTES blocks (larger requests get a block of their own)
+// and released all at once, so filling and tearing down costs one heap
+// call per block rather than one per record.
+class Arena {
+public:
+    Arena() : next(nullptr), left(0), reserved(0) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // align must be a power of two no larger than alignof(max_align_t).
+    void* allocate(size_t bytes, size_t align = alignof(max_align_t)) {
+        size_t skip = static_cast<size_t>(-reinterpret_cast<uintptr_t>(next)) & (align - 1);
+        if (skip + bytes <= left) {
+            next += skip;
+            left -= skip;
+        } else {
+            size_t blockSize = max(bytes, ARENA_BLOCK_BYTES);
+            blocks.emplace_back(new max_align_t[(blockSize + sizeof(max_align_t) - 1) / sizeof(max_align_t)]);
+            next = reinterpret_cast<char*>(blocks.back().get());
+            left = blockSize;
+            reserved += blockSize;
+        }
+        void* p = next;
+        next += bytes;
+        left -= bytes;
+        return p;
+    }
+
+    // Copies n bytes of text; the copy is not NUL-terminated.
+    const char* copy(const char* text, size_t n) {
+        char* p = static_cast<char*>(allocate(n, 1));
+        memcpy(p, text, n);
+        return p;
+    }
+
+    size_t bytesReserved() const { return reserved; }
+
+private:
+    vector<unique_ptr<max_align_t[]>> blocks;
+    char* next;
+    size_t left;
+    size_t reserved;
+};
+
+// Free-list pool of equal-sized blocks on top of an Arena: released blocks
+// are reused by the next allocation, and everything goes back to the heap
+// with the pool. The block size is fixed by the first allocation.
+class SlabPool {
+public:
+    SlabPool() : blockSize(0), freeList(nullptr), inUse(0) {}
+
+    void* allocate(size_t bytes) {
+        if (blockSize == 0) blockSize = max(bytes, sizeof(void*));
+        inUse++;
+        if (freeList) {
+            void* p = freeList;
+            freeList = *static_cast<void**>(p);
+            return p;
+        }
+        return arena.allocate(blockSize);
+    }
+
+    void release(void* p) {
+        *static_cast<void**>(p) = freeList;
+        freeList = p;
+        inUse--;
+    }
+
+    bool fits(size_t bytes) const { return blockSize == 0 || blockSize == max(bytes, sizeof(void*)); }
+    size_t blocksInUse() const { return inUse; }
+    size_t blockBytes() const { return blockSize; }  // 0 until the first allocation
+    size_t bytesReserved() const { return arena.bytesReserved(); }
+
+private:
+    Arena arena;
+    size_t blockSize;
+    void* freeList;
+    size_t inUse;
+};
+
+// Allocator that serves single-object allocations of one size (container
+// nodes) from a SlabPool and everything else (bucket arrays) from the heap.
+template <class T>
+struct PoolAllocator {
+    typedef T value_type;
+
+    explicit PoolAllocator(SlabPool* pool) : pool(pool) {}
+    template <class U>
+    PoolAllocator(const PoolAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n) {
+        if (n == 1 && pool->fits(sizeof(T))) return static_cast<T*>(pool->allocate(sizeof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (n == 1 && pool->fits(sizeof(T))) pool->release(p);
+        else ::operator delete(p);
+    }
+
+    SlabPool* pool;
+};
+
+template <class T, class U>
+bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b) { return a.pool == b.pool; }
+template <class T, class U>
+bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b) { return a.pool != b.pool; }
+
+// cin as the program started with it. Scripted sessions (--load-test)
+// swap in their own buffer; prompts that only make sense on a terminal check
+// consoleInput() rather than isatty alone.
+streambuf* const CONSOLE_INPUT = cin.rdbuf();
+
+bool consoleInput() {
+    return cin.rdbuf() == CONSOLE_INPUT && isatty(STDIN_FILENO);
+}
 
 string getPassword() {
+    if (!consoleInput()) {
+        string password;
+        getline(cin, password);
+        cout << endl;
+        return password;
+    }
     termios oldt;
     tcgetattr(STDIN_FILENO, &oldt);
     termios newt = oldt;
@@ -39,268 +206,3702 @@ string getPassword() {
     return password;
 }
 
-struct Order {
-    int id;
-    string customer;
-    string item;
-    string category;
-    double quantity;
-    double total;
-    string timestamp;
+// Reader/writer lock guarding the order core: searches, menu reads and
+// reports run in parallel, mutations are exclusive.
+class RwLock {
+public:
+    RwLock() { pthread_rwlock_init(&lock, nullptr); }
+    ~RwLock() { pthread_rwlock_destroy(&lock); }
+    RwLock(const RwLock&) = delete;
+    RwLock& operator=(const RwLock&) = delete;
+    void lockShared() { pthread_rwlock_rdlock(&lock); }
+    void lockExclusive() { pthread_rwlock_wrlock(&lock); }
+    void unlock() { pthread_rwlock_unlock(&lock); }
+private:
+    pthread_rwlock_t lock;
 };
 
-struct Feedback {
-    int orderId;
-    string message;
-    string timestamp;
+class ReadGuard {
+public:
+    explicit ReadGuard(RwLock& l) : lock(l) { lock.lockShared(); }
+    ~ReadGuard() { lock.unlock(); }
+private:
+    RwLock& lock;
 };
 
-struct OrderNode {
-    Order order;
-    OrderNode* next;
+class WriteGuard {
+public:
+    explicit WriteGuard(RwLock& l) : lock(l) { lock.lockExclusive(); }
+    ~WriteGuard() { lock.unlock(); }
+private:
+    RwLock& lock;
 };
 
-struct FeedbackNode {
-    Feedback feedback;
-    FeedbackNode* next;
+enum class Category : uint8_t { Food, Drink, Other };
+enum class OrderStatus : uint8_t { Active, Deleted };
+enum class KitchenState : uint8_t { Pending, Cooking, Ready };
+
+Category parseCategory(const char* name, size_t len) {
+    if (len == 4 && memcmp(name, "food", 4) == 0) return Category::Food;
+    if (len == 5 && memcmp(name, "drink", 5) == 0) return Category::Drink;
+    return Category::Other;
+}
+
+Category parseCategory(const string& name) {
+    return parseCategory(name.data(), name.size());
+}
+
+const char* categoryName(Category category) {
+    switch (category) {
+        case Category::Food: return "food";
+        case Category::Drink: return "drink";
+        default: return "other";
+    }
+}
+
+const char* kitchenStateName(KitchenState state) {
+    switch (state) {
+        case KitchenState::Pending: return "PENDING";
+        case KitchenState::Cooking: return "COOKING";
+        default: return "READY";
+    }
+}
+
+// Order times are kept as Unix epoch seconds and shown as local
+// "YYYY-MM-DD HH:MM:SS".
+string formatTime(int64_t epoch) {
+    time_t t = static_cast<time_t>(epoch);
+    tm lt;
+    localtime_r(&t, &lt);
+    char buf[20];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &lt);
+    return string(buf);
+}
+
+// Accepts "YYYY-MM-DD HH:MM:SS" or "YYYY-MM-DD HH:MM" in local time.
+bool parseTime(const string& text, int64_t& epoch) {
+    tm lt;
+    memset(&lt, 0, sizeof(lt));
+    int fields = sscanf(text.c_str(), "%d-%d-%d %d:%d:%d", &lt.tm_year, &lt.tm_mon, &lt.tm_mday,
+                        &lt.tm_hour, &lt.tm_min, &lt.tm_sec);
+    if (fields < 5) return false;
+    lt.tm_year -= 1900;
+    lt.tm_mon -= 1;
+    lt.tm_isdst = -1;
+    time_t t = mktime(&lt);
+    if (t == static_cast<time_t>(-1)) return false;
+    epoch = t;
+    return true;
+}
+
+string dayOf(int64_t epoch) {
+    return formatTime(epoch).substr(0, 10);
+}
+
+int64_t startOfDay(int64_t epoch) {
+    time_t t = static_cast<time_t>(epoch);
+    tm lt;
+    localtime_r(&t, &lt);
+    lt.tm_hour = lt.tm_min = lt.tm_sec = 0;
+    lt.tm_isdst = -1;
+    return mktime(&lt);
+}
+
+// Parses "YYYY-MM-DD HH:MM[:SS]" local times without sscanf. Midnight of
+// the last day seen is cached, so a run of rows from one day costs one
+// mktime; days that are not 24 hours long (DST changes) use mktime for
+// every row. One parser per thread.
+class TimeParser {
+public:
+    TimeParser() : year(-1), month(0), day(0), dayStart(0), dayLength(0) {}
+
+    bool parse(const char* text, size_t len, int64_t& epoch) {
+        static const char separators[] = "-- ::";
+        int fields[6] = {0, 0, 0, 0, 0, 0};
+        size_t count = 0;
+        const char* p = text;
+        const char* end = text + len;
+        while (count < 6 && p < end && *p >= '0' && *p <= '9') {
+            int value = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+                if (value > 100000) return false;
+                value = value * 10 + (*p - '0');
+            }
+            fields[count++] = value;
+            if (count < 6 && p < end) {
+                if (*p != separators[count - 1]) break;
+                ++p;
+            }
+        }
+        if (count < 5) return false;
+        if (fields[0] != year || fields[1] != month || fields[2] != day) {
+            tm lt;
+            memset(&lt, 0, sizeof(lt));
+            lt.tm_year = fields[0] - 1900;
+            lt.tm_mon = fields[1] - 1;
+            lt.tm_mday = fields[2];
+            lt.tm_isdst = -1;
+            time_t start = mktime(&lt);
+            if (start == static_cast<time_t>(-1)) return false;
+            year = fields[0];
+            month = fields[1];
+            day = fields[2];
+            dayStart = start;
+            dayLength = startOfDay(start + 26 * 3600) - start;
+        }
+        if (dayLength == 86400 && fields[3] < 24 && fields[4] < 60 && fields[5] < 60) {
+            epoch = dayStart + fields[3] * 3600 + fields[4] * 60 + fields[5];
+            return true;
+        }
+        tm lt;
+        memset(&lt, 0, sizeof(lt));
+        lt.tm_year = fields[0] - 1900;
+        lt.tm_mon = fields[1] - 1;
+        lt.tm_mday = fields[2];
+        lt.tm_hour = fields[3];
+        lt.tm_min = fields[4];
+        lt.tm_sec = fields[5];
+        lt.tm_isdst = -1;
+        time_t t = mktime(&lt);
+        if (t == static_cast<time_t>(-1)) return false;
+        epoch = t;
+        return true;
+    }
+
+private:
+    int year;
+    int month;
+    int day;
+    int64_t dayStart;
+    int64_t dayLength;
 };
 
-class OrderManager {
+// Money is kept in santim (1/100 birr) and quantities in thousandths of a
+// portion or liter, so totals and aggregates are exact integer sums.
+typedef int64_t Money;
+typedef int64_t Quantity;
+const int MONEY_DIGITS = 2;
+const int QUANTITY_DIGITS = 3;
+const Quantity QUANTITY_ONE = 1000;
+
+// Parses a plain decimal such as "12", "-3.5" or "1050.00" into an integer
+// scaled by 10^digits, rounding extra fractional digits half away from zero.
+bool parseFixed(const char* text, size_t len, int digits, int64_t& value) {
+    size_t i = 0;
+    bool negative = len > 0 && text[0] == '-';
+    if (negative || (len > 0 && text[0] == '+')) i++;
+    int64_t whole = 0;
+    size_t start = i;
+    for (; i < len && text[i] >= '0' && text[i] <= '9'; ++i) {
+        if (whole > (INT64_MAX / 10) / 1000) return false;
+        whole = whole * 10 + (text[i] - '0');
+    }
+    bool anyDigits = i > start;
+    int64_t frac = 0;
+    int fracDigits = 0;
+    bool roundUp = false;
+    if (i < len && text[i] == '.') {
+        for (++i; i < len && text[i] >= '0' && text[i] <= '9'; ++i) {
+            anyDigits = true;
+            if (fracDigits < digits) {
+                frac = frac * 10 + (text[i] - '0');
+                fracDigits++;
+            } else if (fracDigits == digits) {
+                roundUp = text[i] >= '5';
+                fracDigits++;
+            }
+        }
+    }
+    if (!anyDigits || i != len) return false;
+    for (int d = min(fracDigits, digits); d < digits; ++d) frac *= 10;
+    int64_t scale = 1;
+    for (int d = 0; d < digits; ++d) scale *= 10;
+    value = whole * scale + frac + (roundUp ? 1 : 0);
+    if (negative) value = -value;
+    return true;
+}
+
+bool parseFixed(const string& text, int digits, int64_t& value) {
+    return parseFixed(text.data(), text.size(), digits, value);
+}
+
+// Writes a scaled integer with at least minDecimals fractional digits
+// (further digits only when they are not zero) into the bytes just before
+// end, and returns where it starts. 24 bytes are always enough.
+char* writeFixed(char* end, int64_t value, int digits, int minDecimals) {
+    char* p = end;
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    int shown = digits;
+    while (shown > minDecimals && magnitude % 10 == 0) {
+        magnitude /= 10;
+        shown--;
+    }
+    for (int d = 0; d < shown; ++d) {
+        *--p = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    }
+    if (shown > 0) *--p = '.';
+    do {
+        *--p = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) *--p = '-';
+    return p;
+}
+
+string formatFixed(int64_t value, int digits, int minDecimals) {
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    return string(writeFixed(end, value, digits, minDecimals), end);
+}
+
+string formatMoney(Money amount) {
+    return formatFixed(amount, MONEY_DIGITS, MONEY_DIGITS);
+}
+
+string formatQuantity(Quantity quantity) {
+    return formatFixed(quantity, QUANTITY_DIGITS, 2);
+}
+
+// quantity x unitPrice, rounded to the nearest santim.
+Money lineAmount(Quantity quantity, Money unitPrice) {
+    int64_t scaled = quantity * unitPrice;
+    return (scaled + (scaled < 0 ? -QUANTITY_ONE / 2 : QUANTITY_ONE / 2)) / QUANTITY_ONE;
+}
+
+const size_t LIST_PAGE_ROWS = 50;          // tickets per listing page
+const size_t CUSTOMER_MATCHES_SHOWN = 20;  // customers listed for a partial name
+const size_t TEXT_PAGE_BYTES = 64 * 1024;  // console output is written in chunks of this size
+
+// Builds console tables in one reusable buffer and writes it out a page at
+// a time, replacing per-cell stream manipulators and per-line flushes.
+// Numbers and times are formatted by hand, so steady-state rendering does
+// not allocate.
+class TextBuffer {
+public:
+    explicit TextBuffer(ostream& out) : out(out), cellStart(0), dayStart(0), dayEnd(0) {
+        buf.reserve(TEXT_PAGE_BYTES + 4096);
+    }
+
+    ~TextBuffer() { flush(); }
+
+    TextBuffer(const TextBuffer&) = delete;
+    TextBuffer& operator=(const TextBuffer&) = delete;
+
+    TextBuffer& str(const string& s) {
+        buf.append(s);
+        return *this;
+    }
+
+    TextBuffer& str(const char* s) {
+        buf.append(s);
+        return *this;
+    }
+
+    TextBuffer& str(const char* s, size_t n) {
+        buf.append(s, n);
+        return *this;
+    }
+
+    TextBuffer& num(int64_t value) {
+        return fixed(value, 0, 0);
+    }
+
+    TextBuffer& fixed(int64_t value, int digits, int minDecimals) {
+        char tmp[24];
+        char* end = tmp + sizeof(tmp);
+        char* start = writeFixed(end, value, digits, minDecimals);
+        buf.append(start, static_cast<size_t>(end - start));
+        return *this;
+    }
+
+    TextBuffer& money(Money amount) { return fixed(amount, MONEY_DIGITS, MONEY_DIGITS); }
+    TextBuffer& quantity(Quantity units) { return fixed(units, QUANTITY_DIGITS, 2); }
+
+    // "YYYY-MM-DD HH:MM:SS" in local time. The date is formatted once per
+    // day; days that are not 24 hours long (DST changes) use localtime.
+    TextBuffer& time(int64_t epoch) {
+        if (epoch < dayStart || epoch >= dayEnd) {
+            dayStart = startOfDay(epoch);
+            dayEnd = startOfDay(dayStart + 26 * 3600);
+            time_t t = static_cast<time_t>(dayStart);
+            tm lt;
+            localtime_r(&t, &lt);
+            strftime(date, sizeof(date), "%Y-%m-%d ", &lt);
+        }
+        if (dayEnd - dayStart != 86400) return str(formatTime(epoch));
+        int64_t secs = epoch - dayStart;
+        char clock[8] = {
+            static_cast<char>('0' + secs / 36000), static_cast<char>('0' + secs / 3600 % 10), ':',
+            static_cast<char>('0' + secs % 3600 / 600), static_cast<char>('0' + secs % 3600 / 60 % 10), ':',
+            static_cast<char>('0' + secs % 60 / 10), static_cast<char>('0' + secs % 10)};
+        buf.append(date, 11);
+        buf.append(clock, sizeof(clock));
+        return *this;
+    }
+
+    TextBuffer& repeat(char c, size_t count) {
+        buf.append(count, c);
+        return *this;
+    }
+
+    // Pads what was written since the last pad() or endLine() to width,
+    // like left << setw(width).
+    TextBuffer& pad(size_t width) {
+        size_t used = buf.size() - cellStart;
+        if (used < width) buf.append(width - used, ' ');
+        cellStart = buf.size();
+        return *this;
+    }
+
+    void endLine() {
+        buf.push_back('\n');
+        cellStart = buf.size();
+        if (buf.size() >= TEXT_PAGE_BYTES) flush();
+    }
+
+    void flush() {
+        if (!buf.empty()) {
+            out.write(buf.data(), static_cast<streamsize>(buf.size()));
+            buf.clear();
+        }
+        out.flush();
+        cellStart = 0;
+    }
+
 private:
-    OrderNode* ordersHead;
-    FeedbackNode* feedbacksHead;
-    map<int, pair<string, pair<string, double>>> menu;
-    int nextId;
-    int orderCount;
-    const string fileName = "orders.txt";
-    const string feedbackFileName = "feedbacks.txt";
-    const string passwordFile = "password.txt";
-    const string chefPasswordFile = "chef_password.txt";
-    const string menuFile = "menu.txt";
-    string cashierPassword;
-    string chefPassword;
+    ostream& out;
+    string buf;
+    size_t cellStart;
+    int64_t dayStart;
+    int64_t dayEnd;
+    char date[12];
+};
 
-    string currentTime() const {
-        time_t t = time(nullptr);
-        tm* lt = localtime(&t);
-        char buf[20];
-        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", lt);
-        return string(buf);
+int64_t steadyNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Operations timed by Metrics. Keep METRIC_NAMES in the same order.
+enum class Metric {
+    PlaceOrder, PlaceBatch, LookupOrder, ChangeQuantity, CancelOrder, AdvanceKitchen,
+    AddFeedback, SearchFeedback, SalesReport, DailyReport, ListOrders, CustomerLookup,
+    JournalWrite, Fsync, CommitWait, SnapshotSave, CsvExport, ArchiveDays, StartupLoad, Count
+};
+
+const size_t METRIC_COUNT = static_cast<size_t>(Metric::Count);
+const char* const METRIC_NAMES[METRIC_COUNT] = {
+    "place_order", "place_batch", "lookup_order", "change_quantity", "cancel_order", "advance_kitchen",
+    "add_feedback", "search_feedback", "sales_report", "daily_report", "list_orders", "customer_lookup",
+    "journal_write", "fsync", "commit_wait", "snapshot_save", "csv_export", "archive_days", "startup_load"};
+
+// Histogram upper bounds in nanoseconds (10 us .. 5 s); one more bucket
+// holds everything slower.
+const uint64_t LATENCY_BOUNDS_NS[] = {
+    10000, 50000, 100000, 500000, 1000000, 5000000, 10000000,
+    50000000, 100000000, 500000000, 1000000000, 5000000000};
+const size_t LATENCY_BUCKETS = sizeof(LATENCY_BOUNDS_NS) / sizeof(LATENCY_BOUNDS_NS[0]) + 1;
+
+// Per-operation call counts, latency histograms and bytes written. Every
+// field is a relaxed atomic, so recording costs a few uncontended
+// increments and never takes a lock; readers see a near-consistent view.
+class Metrics {
+public:
+    Metrics() {
+        for (OpStats& op : ops) {
+            op.count = 0;
+            op.totalNs = 0;
+            op.maxNs = 0;
+            op.bytes = 0;
+            for (atomic<uint64_t>& bucket : op.buckets) bucket = 0;
+        }
     }
-    
-    void loadPasswords() {
-        ifstream fin(passwordFile);
-        if (fin) {
-            getline(fin, cashierPassword);
-        } else {
-            cashierPassword = "123";
-            savePassword();
+
+    void record(Metric metric, uint64_t nanos) {
+        OpStats& op = ops[static_cast<size_t>(metric)];
+        size_t b = lower_bound(LATENCY_BOUNDS_NS, LATENCY_BOUNDS_NS + LATENCY_BUCKETS - 1, nanos)
+                 - LATENCY_BOUNDS_NS;
+        op.count.fetch_add(1, memory_order_relaxed);
+        op.totalNs.fetch_add(nanos, memory_order_relaxed);
+        op.buckets[b].fetch_add(1, memory_order_relaxed);
+        uint64_t seen = op.maxNs.load(memory_order_relaxed);
+        while (nanos > seen && !op.maxNs.compare_exchange_weak(seen, nanos, memory_order_relaxed)) {}
+    }
+
+    void addBytes(Metric metric, uint64_t bytes) {
+        ops[static_cast<size_t>(metric)].bytes.fetch_add(bytes, memory_order_relaxed);
+    }
+
+    // Prometheus text exposition format: one histogram family for latency
+    // and one counter family for bytes written.
+    void writePrometheus(TextBuffer& out) const {
+        out.str("# HELP order_op_duration_seconds Latency of order store operations.").endLine();
+        out.str("# TYPE order_op_duration_seconds histogram").endLine();
+        for (size_t i = 0; i < METRIC_COUNT; ++i) {
+            const OpStats& op = ops[i];
+            uint64_t cumulative = 0;
+            for (size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+                cumulative += op.buckets[b].load(memory_order_relaxed);
+                out.str("order_op_duration_seconds_bucket{op=\"").str(METRIC_NAMES[i]).str("\",le=\"");
+                if (b + 1 < LATENCY_BUCKETS) out.fixed(static_cast<int64_t>(LATENCY_BOUNDS_NS[b]), 9, 1);
+                else out.str("+Inf");
+                out.str("\"} ").num(static_cast<int64_t>(cumulative)).endLine();
+            }
+            out.str("order_op_duration_seconds_sum{op=\"").str(METRIC_NAMES[i]).str("\"} ")
+               .fixed(static_cast<int64_t>(op.totalNs.load(memory_order_relaxed)), 9, 1).endLine();
+            out.str("order_op_duration_seconds_count{op=\"").str(METRIC_NAMES[i]).str("\"} ")
+               .num(static_cast<int64_t>(cumulative)).endLine();
+        }
+        out.str("# HELP order_op_bytes_written_total Bytes written to disk by an operation.").endLine();
+        out.str("# TYPE order_op_bytes_written_total counter").endLine();
+        for (size_t i = 0; i < METRIC_COUNT; ++i) {
+            uint64_t bytes = ops[i].bytes.load(memory_order_relaxed);
+            if (bytes == 0) continue;
+            out.str("order_op_bytes_written_total{op=\"").str(METRIC_NAMES[i]).str("\"} ")
+               .num(static_cast<int64_t>(bytes)).endLine();
+        }
+    }
+
+    // Console table of the operations seen so far. Percentiles are the
+    // upper bound of the histogram bucket they fall in.
+    void writeTable(TextBuffer& out) const {
+        out.str("Operation").pad(18).str("Count").pad(10).str("Avg (us)").pad(12)
+           .str("p50 <= us").pad(12).str("p99 <= us").pad(12).str("Max (us)").pad(12).str("Bytes").endLine();
+        out.repeat('-', 86).endLine();
+        for (size_t i = 0; i < METRIC_COUNT; ++i) {
+            const OpStats& op = ops[i];
+            uint64_t count = op.count.load(memory_order_relaxed);
+            if (count == 0) continue;
+            out.str(METRIC_NAMES[i]).pad(18).num(static_cast<int64_t>(count)).pad(10)
+               .fixed(static_cast<int64_t>(op.totalNs.load(memory_order_relaxed) / count / 100), 1, 1).pad(12);
+            writeBound(out, op, count, 0.50).pad(12);
+            writeBound(out, op, count, 0.99).pad(12);
+            out.fixed(static_cast<int64_t>(op.maxNs.load(memory_order_relaxed) / 100), 1, 1).pad(12)
+               .num(static_cast<int64_t>(op.bytes.load(memory_order_relaxed))).endLine();
+        }
+    }
+
+private:
+    struct OpStats {
+        atomic<uint64_t> count;
+        atomic<uint64_t> totalNs;
+        atomic<uint64_t> maxNs;
+        atomic<uint64_t> bytes;
+        atomic<uint64_t> buckets[LATENCY_BUCKETS];
+    };
+
+    static TextBuffer& writeBound(TextBuffer& out, const OpStats& op, uint64_t count, double p) {
+        uint64_t rank = static_cast<uint64_t>(p * count), seen = 0;
+        for (size_t b = 0; b + 1 < LATENCY_BUCKETS; ++b) {
+            seen += op.buckets[b].load(memory_order_relaxed);
+            if (seen > rank) return out.num(static_cast<int64_t>(LATENCY_BOUNDS_NS[b] / 1000));
+        }
+        return out.str("slower");
+    }
+
+    OpStats ops[METRIC_COUNT];
+};
+
+// Times the enclosing scope into one Metrics entry.
+class OpTimer {
+public:
+    OpTimer(Metrics& metrics, Metric metric) : metrics(metrics), metric(metric), start(steadyNanos()) {}
+    ~OpTimer() { metrics.record(metric, static_cast<uint64_t>(steadyNanos() - start)); }
+
+    OpTimer(const OpTimer&) = delete;
+    OpTimer& operator=(const OpTimer&) = delete;
+
+private:
+    Metrics& metrics;
+    Metric metric;
+    int64_t start;
+};
+
+// fsyncs the directory holding path, so a rename into it survives a crash.
+void syncDirectory(const string& path) {
+    size_t slash = path.rfind('/');
+    string dir = slash == string::npos ? "." : path.substr(0, slash);
+    int fd = open(dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+// Replaces one file atomically. Contents are written to <path>.tmp, and
+// commit() fsyncs them, renames the temporary over path and fsyncs the
+// directory, so after a crash the file is either the old version or the
+// new one, never a torn mix. A file that is never committed is removed.
+class AtomicFile {
+public:
+    AtomicFile(const string& path, Metrics* metrics = nullptr, ios::openmode mode = ios::out)
+        : path(path), tmpName(path + ".tmp"), out(tmpName, mode | ios::trunc), metrics(metrics),
+          committed(false) {}
+
+    ~AtomicFile() {
+        if (!committed) {
+            out.close();
+            remove(tmpName.c_str());
+        }
+    }
+
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+
+    ofstream& stream() { return out; }
+    const string& tempPath() const { return tmpName; }
+
+    // durable = false skips the fsyncs, for files that are cheap to lose
+    // but must never be read half-written.
+    bool commit(bool durable = true) {
+        out.flush();
+        if (!out) return false;
+        out.close();
+        if (durable) {
+            int fd = open(tmpName.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+            {
+                unique_ptr<OpTimer> timer(metrics ? new OpTimer(*metrics, Metric::Fsync) : nullptr);
+                bool synced = fsync(fd) == 0;
+                close(fd);
+                if (!synced) return false;
+            }
+        }
+        if (rename(tmpName.c_str(), path.c_str()) != 0) return false;
+        committed = true;
+        if (durable) syncDirectory(path);
+        return true;
+    }
+
+private:
+    string path;
+    string tmpName;
+    ofstream out;
+    Metrics* metrics;
+    bool committed;
+};
+
+// Group commit for the order journal. Mutations append their records
+// under the store lock and get a sequence number; one flusher thread
+// writes whatever has accumulated with a single write and fsync, and the
+// callers wait for their sequence after dropping the lock, so concurrent
+// tills share fsyncs instead of queueing behind one each. When more than
+// one caller is waiting, the flusher holds the batch open for up to the
+// durability window to let more records join it. A failed write or fsync
+// fails that batch and everything after it until reset() clears it:
+// once fsync has failed, later ones cannot vouch for the earlier pages.
+class GroupCommit {
+public:
+    GroupCommit(Metrics& metrics, const string& name)
+        : metrics(metrics), name(name), fd(-1), window(0), appended(0), taken(0), durable(0),
+          failedFrom(0), committers(0), running(false), writing(false), stopping(false) {}
+
+    ~GroupCommit() { stop(); }
+
+    GroupCommit(const GroupCommit&) = delete;
+    GroupCommit& operator=(const GroupCommit&) = delete;
+
+    void start(int journalFd, chrono::microseconds durabilityWindow) {
+        fd = journalFd;
+        window = durabilityWindow;
+        running = true;
+        flusher = thread(&GroupCommit::flushLoop, this);
+    }
+
+    // Writes out everything appended so far and stops the flusher.
+    void stop() {
+        if (!flusher.joinable()) return;
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        flusher.join();
+    }
+
+    uint64_t append(const string& records) {
+        lock_guard<mutex> guard(lock);
+        pending += records;
+        wake.notify_one();
+        return ++appended;
+    }
+
+    // Blocks until the records with this sequence number are on disk, or
+    // could not be put there; returns false in the latter case.
+    bool waitDurable(uint64_t seq) {
+        OpTimer timer(metrics, Metric::CommitWait);
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [&] { return durable >= seq || (failedFrom != 0 && seq >= failedFrom) || !running; });
+        return durable >= seq;
+    }
+
+    // Whether the records with this sequence number are on disk, without
+    // waiting for them.
+    bool isDurable(uint64_t seq) {
+        lock_guard<mutex> guard(lock);
+        return durable >= seq;
+    }
+
+    const string& fileName() const { return name; }
+
+    // Every appended record has just been written out another way (a
+    // snapshot, or the whole file rewritten): drop what is still pending,
+    // empty the file or switch to reopened, a fresh descriptor for it,
+    // clear any earlier write failure and release the waiters. The caller
+    // holds the lock appends are made under, so nothing is appended
+    // meanwhile.
+    bool reset(int reopened = -1) {
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [&] { return !writing; });
+        pending.clear();
+        taken = appended;
+        if (reopened >= 0) fd = reopened;
+        bool emptied = reopened >= 0 || (fd >= 0 && ftruncate(fd, 0) == 0);
+        durable = appended;
+        if (emptied) failedFrom = 0;
+        done.notify_all();
+        return emptied;
+    }
+
+    // Counts a mutation that may append and then wait; the flusher only
+    // holds a batch open when more than one is in flight.
+    void enter() { committers.fetch_add(1, memory_order_relaxed); }
+    void leave() { committers.fetch_sub(1, memory_order_relaxed); }
+
+private:
+    Metrics& metrics;
+    string name;
+    int fd;
+    chrono::microseconds window;
+    mutex lock;
+    condition_variable wake;   // flusher: records pending or stopping
+    condition_variable done;   // waiters: durable moved
+    string pending;
+    uint64_t appended;         // sequence of the last appended record batch
+    uint64_t taken;            // last sequence handed to a write
+    uint64_t durable;          // last sequence known to be on disk
+    uint64_t failedFrom;       // first sequence that could not be made durable; 0 if none
+    atomic<int> committers;
+    bool running;
+    bool writing;
+    bool stopping;
+    thread flusher;
+
+    void flushLoop() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) break;
+            if (window.count() > 0 && !stopping && committers.load(memory_order_relaxed) > 1) {
+                wake.wait_for(guard, window, [&] {
+                    return stopping || appended - taken >= static_cast<uint64_t>(committers.load(memory_order_relaxed));
+                });
+            }
+            string batch;
+            batch.swap(pending);
+            uint64_t first = taken + 1;
+            uint64_t seq = appended;
+            taken = seq;
+            bool failing = failedFrom != 0;
+            writing = true;
+            guard.unlock();
+            // Nothing goes after a failed batch: it may have left a torn record.
+            bool written = fd >= 0 && !failing;
+            if (written) {
+                OpTimer timer(metrics, Metric::JournalWrite);
+                written = write(fd, batch.data(), batch.size()) == static_cast<ssize_t>(batch.size());
+                metrics.addBytes(Metric::JournalWrite, batch.size());
+            }
+            if (written) {
+                OpTimer timer(metrics, Metric::Fsync);
+                written = fsync(fd) == 0;
+            }
+            if (!written && !failing) {
+                cout << "Warning: could not write to " << name << ".\n";
+            }
+            guard.lock();
+            writing = false;
+            if (!written && failedFrom == 0) failedFrom = first;
+            if (written) durable = max(durable, seq);
+            done.notify_all();
+        }
+        running = false;
+        done.notify_all();
+    }
+};
+
+// Declared in a mutation before its WriteGuard. After the guard's scope has
+// dropped the store lock, wait() blocks until the journal records the
+// mutation appended (seq, 0 for none) are durable and reports whether they
+// made it.
+class CommitWait {
+public:
+    explicit CommitWait(GroupCommit& journal) : seq(0), journal(journal) { journal.enter(); }
+    ~CommitWait() {
+        if (seq != 0) journal.waitDurable(seq);
+        journal.leave();
+    }
+
+    bool wait(string& error) {
+        uint64_t waited = seq;
+        seq = 0;
+        if (waited == 0 || journal.waitDurable(waited)) return true;
+        error = "The change was made but could not be saved to " + journal.fileName() +
+                " and may be lost on restart; do not repeat it.";
+        return false;
+    }
+
+    CommitWait(const CommitWait&) = delete;
+    CommitWait& operator=(const CommitWait&) = delete;
+
+    uint64_t seq;
+
+private:
+    GroupCommit& journal;
+};
+
+// Asks whether to show the next page of a listing; only on a terminal.
+bool continuePaging(size_t shown, size_t total, const char* noun) {
+    cout << "-- " << shown << " of " << total << " " << noun
+         << " shown, Enter for more, q to stop -- " << flush;
+    string answer;
+    return getline(cin, answer) && answer != "q" && answer != "Q";
+}
+
+// itemId is the menu item ID. Items that are no longer on the menu (renamed
+// or removed since the order was written) get negative IDs for the session.
+// unitPrice is the menu price when the order was placed, so later price
+// changes do not reprice existing tickets.
+struct OrderLine {
+    int itemId;
+    Category category;
+    Quantity quantity;
+    Money unitPrice;
+};
+
+// Line items of one ticket. Most tickets carry one or two dishes; those are
+// stored inside the order record, so the order table needs no heap block
+// per order. Larger tickets move their lines to one heap array.
+class TicketLines {
+public:
+    TicketLines() : count(0), cap(INLINE_TICKET_LINES), heap(nullptr) {}
+
+    TicketLines(const TicketLines& other) : count(0), cap(INLINE_TICKET_LINES), heap(nullptr) {
+        reserve(other.count);
+        copy(other.begin(), other.end(), begin());
+        count = other.count;
+    }
+
+    TicketLines(TicketLines&& other) noexcept : count(0), cap(INLINE_TICKET_LINES), heap(nullptr) {
+        *this = std::move(other);
+    }
+
+    TicketLines& operator=(const TicketLines& other) {
+        if (this != &other) {
+            TicketLines copied(other);
+            *this = std::move(copied);
+        }
+        return *this;
+    }
+
+    TicketLines& operator=(TicketLines&& other) noexcept {
+        if (this == &other) return *this;
+        delete[] heap;
+        count = other.count;
+        cap = other.cap;
+        heap = other.heap;
+        if (!heap) copy(other.inlineLines, other.inlineLines + count, inlineLines);
+        other.count = 0;
+        other.cap = INLINE_TICKET_LINES;
+        other.heap = nullptr;
+        return *this;
+    }
+
+    ~TicketLines() { delete[] heap; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t heapBytes() const { return heap ? cap * sizeof(OrderLine) : 0; }
+
+    OrderLine* begin() { return heap ? heap : inlineLines; }
+    OrderLine* end() { return begin() + count; }
+    const OrderLine* begin() const { return heap ? heap : inlineLines; }
+    const OrderLine* end() const { return begin() + count; }
+    OrderLine& operator[](size_t i) { return begin()[i]; }
+    const OrderLine& operator[](size_t i) const { return begin()[i]; }
+
+    void reserve(size_t n) {
+        if (n <= cap) return;
+        OrderLine* grown = new OrderLine[n];
+        copy(begin(), end(), grown);
+        delete[] heap;
+        heap = grown;
+        cap = static_cast<uint32_t>(n);
+    }
+
+    void push_back(const OrderLine& line) {
+        if (count == cap) reserve(cap * 2);
+        begin()[count++] = line;
+    }
+
+    // Drops the lines and any heap array (deleted tickets keep none).
+    void clear() {
+        delete[] heap;
+        heap = nullptr;
+        count = 0;
+        cap = INLINE_TICKET_LINES;
+    }
+
+private:
+    uint32_t count;
+    uint32_t cap;
+    OrderLine* heap;
+    OrderLine inlineLines[INLINE_TICKET_LINES];
+};
+
+// One ticket: every dish a table orders shares one ID, one commit and one
+// total. Deleted tickets keep their ID but no lines. kitchen moves forward
+// only: pending -> cooking -> ready.
+struct Order {
+    int id;
+    OrderStatus status;
+    KitchenState kitchen;
+    uint32_t menuVersion;  // menu snapshot the ticket was priced against; 0 if unknown
+    Money total;
+    int64_t createdAt;
+    string customer;
+    TicketLines lines;
+
+    Order() : id(0), status(OrderStatus::Active), kitchen(KitchenState::Pending), menuVersion(0),
+              total(0), createdAt(0) {}
+};
+
+// orders.bin layout (native byte order): SnapshotHeader, recordCount
+// fixed-width OrderRecords, lineCount LineRecords (each order's lines are
+// contiguous from firstLine), then a pool holding each distinct customer and
+// item name once. Offsets and lengths index into the pool; the item name is
+// only consulted when itemId is not on the menu at load time.
+const char SNAPSHOT_MAGIC[4] = {'O', 'R', 'D', 'B'};
+const uint32_t SNAPSHOT_VERSION = 6;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t recordCount;
+    uint64_t lineCount;
+    uint64_t poolSize;
+};
+
+struct OrderRecord {
+    int32_t id;
+    uint32_t customerOff;
+    uint32_t firstLine;
+    uint16_t customerLen;
+    uint8_t status;
+    uint8_t lineCount;
+    uint8_t kitchen;
+    uint8_t reserved[3];
+    uint32_t menuVersion; // 0 in snapshots written before menus were versioned
+    int64_t total;      // santim
+    int64_t createdAt;
+};
+
+struct LineRecord {
+    int32_t itemId;
+    uint32_t itemOff;
+    uint16_t itemLen;
+    uint8_t category;
+    uint8_t reserved;
+    int32_t quantity;   // thousandths
+    int64_t unitPrice;  // santim
+};
+static_assert(sizeof(SnapshotHeader) == 32, "snapshot header must stay 32 bytes");
+static_assert(sizeof(OrderRecord) == 40, "order record must stay 40 bytes");
+static_assert(sizeof(LineRecord) == 24, "line record must stay 24 bytes");
+
+// One order read by the batch importer; line is the source line number.
+// items holds (menu ID, quantity) pairs.
+struct OrderRequest {
+    vector<pair<int, Quantity>> items;
+    string customer;
+    int line;
+};
+
+Money ticketTotal(const Order& o) {
+    Money total = 0;
+    for (const OrderLine& line : o.lines) {
+        total += lineAmount(line.quantity, line.unitPrice);
+    }
+    return total;
+}
+
+// Whole file mapped read-only for the loaders; empty when the file is
+// missing or empty.
+class MappedFile {
+public:
+    explicit MappedFile(const string& path) : data(nullptr), size(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<const char*>(mapped);
+                size = static_cast<size_t>(st.st_size);
+                madvise(mapped, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data) munmap(const_cast<char*>(data), size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+
+private:
+    const char* data;
+    size_t size;
+};
+
+typedef pair<const char*, const char*> TextRange;
+
+// Cuts [begin, end) into about one LOAD_CHUNK_BYTES slice per core, each
+// ending just after a newline (the last one at end), so no line is split.
+vector<TextRange> splitLines(const char* begin, const char* end) {
+    size_t bytes = static_cast<size_t>(end - begin);
+    size_t parts = max<size_t>(1, min<size_t>(max(1u, thread::hardware_concurrency()), bytes / LOAD_CHUNK_BYTES));
+    vector<TextRange> chunks;
+    const char* start = begin;
+    for (size_t i = 1; i < parts && start < end; ++i) {
+        const char* cut = begin + bytes * i / parts;
+        if (cut <= start) continue;
+        const char* newline = static_cast<const char*>(memchr(cut, '\n', static_cast<size_t>(end - cut)));
+        if (!newline) break;
+        chunks.push_back(TextRange(start, newline + 1));
+        start = newline + 1;
+    }
+    if (start < end) chunks.push_back(TextRange(start, end));
+    return chunks;
+}
+
+// Runs parse(i, chunk) for every chunk, each on its own thread (the first
+// on the caller's), and returns when all are done.
+template <typename Parse>
+void parseChunks(const vector<TextRange>& chunks, Parse parse) {
+    vector<thread> workers;
+    for (size_t i = 1; i < chunks.size(); ++i) {
+        workers.push_back(thread(parse, i, chunks[i]));
+    }
+    if (!chunks.empty()) parse(0, chunks[0]);
+    for (thread& worker : workers) worker.join();
+}
+
+// Hands out the lines of a text range, without the newline.
+class LineScanner {
+public:
+    explicit LineScanner(const TextRange& range) : p(range.first), end(range.second) {}
+
+    bool next(TextRange& line) {
+        if (p >= end) return false;
+        const char* newline = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+        const char* stop = newline ? newline : end;
+        line = TextRange(p, stop);
+        p = newline ? newline + 1 : end;
+        return true;
+    }
+
+private:
+    const char* p;
+    const char* end;
+};
+
+// Splits one line into separator-delimited fields in place (no quoting,
+// as in every file this program writes).
+class FieldScanner {
+public:
+    FieldScanner(const TextRange& line, char separator) : p(line.first), end(line.second), separator(separator) {}
+
+    bool next(TextRange& field) {
+        if (!p) return false;
+        const char* stop = static_cast<const char*>(memchr(p, separator, static_cast<size_t>(end - p)));
+        field = TextRange(p, stop ? stop : end);
+        p = stop ? stop + 1 : nullptr;
+        return true;
+    }
+
+    // Everything after the fields read so far, separators included.
+    bool rest(TextRange& field) {
+        if (!p) return false;
+        field = TextRange(p, end);
+        p = nullptr;
+        return true;
+    }
+
+private:
+    const char* p;
+    const char* end;
+    char separator;
+};
+
+size_t rangeSize(const TextRange& range) {
+    return static_cast<size_t>(range.second - range.first);
+}
+
+bool parseInt(const TextRange& text, int& value) {
+    int64_t wide;
+    if (!parseFixed(text.first, rangeSize(text), 0, wide) || wide < INT32_MIN || wide > INT32_MAX) return false;
+    value = static_cast<int>(wide);
+    return true;
+}
+
+bool parseInt(const string& text, int& value) {
+    return parseInt(TextRange(text.data(), text.data() + text.size()), value);
+}
+
+// One orders.txt row as scanned by a loader thread. Text fields point into
+// the mapped file; itemId is 0 when the item still has to be resolved.
+struct CsvOrderRow {
+    int id;
+    bool deleted;
+    bool hasUnitPrice;
+    Category category;
+    int itemId;
+    Quantity quantity;
+    Money lineTotal;
+    Money unitPrice;
+    int64_t createdAt;
+    TextRange customer;
+    TextRange item;
+};
+
+// One feedbacks.txt line ("order id;time;message") as scanned by a loader
+// thread; the text points into the mapped file.
+struct FeedbackRow {
+    int orderId;
+    TextRange timestamp;
+    TextRange message;
+};
+
+struct ItemSales {
+    Category category;
+    int orders;
+    Quantity quantity;
+    Money revenue;
+};
+
+struct DaySales {
+    int orders;
+    Money revenue;
+    map<int, ItemSales> items;  // keyed by item ID
+};
+
+// Live orders placed under one customer name.
+struct CustomerHistory {
+    string name;           // as written on the latest order
+    vector<int> orderIds;  // oldest first, deleted tickets included
+    int orders;            // not deleted
+    Money spend;           // total of those
+};
+
+const size_t CATEGORY_COUNT = 3;
+
+// Columnar copy of the sales history: one row per sold line item, in time
+// order. Item IDs are dictionary-encoded into small codes so group-bys
+// index flat arrays, and each column is a plain array the scan kernels
+// walk front to back.
+struct SalesColumns {
+    vector<int64_t> epoch;
+    vector<Money> amount;
+    vector<int32_t> quantity;
+    vector<uint16_t> item;         // code into the analytics item dictionary
+    vector<uint8_t> category;
+    vector<uint8_t> hour;          // local hour of day
+    vector<uint8_t> ticketStart;   // 1 on the first line of each order
+    int64_t hourStart = 0;         // local clock hour of the last appended row
+    int64_t hourEnd = 0;
+    uint8_t currentHour = 0;
+
+    size_t size() const { return epoch.size(); }
+
+    void clear() {
+        epoch.clear();
+        amount.clear();
+        quantity.clear();
+        item.clear();
+        category.clear();
+        hour.clear();
+        ticketStart.clear();
+    }
+
+    void reserve(size_t rows) {
+        epoch.reserve(rows);
+        amount.reserve(rows);
+        quantity.reserve(rows);
+        item.reserve(rows);
+        category.reserve(rows);
+        hour.reserve(rows);
+        ticketStart.reserve(rows);
+    }
+
+    // Rows arrive in time order, so the local hour is only looked up when
+    // a row falls outside the current one. It comes from the local clock,
+    // so on a DST change day the repeated or skipped hour is bucketed as
+    // the clock showed it.
+    void append(int64_t at, Money lineAmountValue, Quantity units, uint16_t code,
+                Category cat, bool first) {
+        if (at < hourStart || at >= hourEnd) {
+            time_t t = static_cast<time_t>(at);
+            tm lt;
+            localtime_r(&t, &lt);
+            currentHour = static_cast<uint8_t>(lt.tm_hour);
+            hourStart = at - lt.tm_min * 60 - lt.tm_sec;
+            hourEnd = hourStart + 3600;
+        }
+        epoch.push_back(at);
+        amount.push_back(lineAmountValue);
+        quantity.push_back(static_cast<int32_t>(units));
+        item.push_back(code);
+        category.push_back(static_cast<uint8_t>(cat));
+        hour.push_back(currentHour);
+        ticketStart.push_back(first ? 1 : 0);
+    }
+};
+
+struct SalesTotals {
+    int64_t orders = 0;
+    Money revenue = 0;
+    Quantity quantity = 0;
+    int64_t hourOrders[24] = {};
+    Money hourRevenue[24] = {};
+    Money categoryRevenue[CATEGORY_COUNT] = {};
+    Quantity categoryQuantity[CATEGORY_COUNT] = {};
+    vector<Money> itemRevenue;      // indexed by item code
+    vector<Quantity> itemQuantity;
+};
+
+// Aggregates rows [lo, hi) into t. Each pass is a straight loop over one or
+// two columns with no data-dependent branches: the totals vectorize and the
+// group-by tables are small enough to stay in L1.
+void scanSales(const SalesColumns& c, size_t lo, size_t hi, SalesTotals& t) {
+    const int64_t* amount = c.amount.data();
+    const int32_t* quantity = c.quantity.data();
+    const uint8_t* start = c.ticketStart.data();
+    const uint8_t* hour = c.hour.data();
+    const uint8_t* category = c.category.data();
+    const uint16_t* item = c.item.data();
+
+    int64_t orders = 0, revenue = 0, units = 0;
+    for (size_t i = lo; i < hi; ++i) {
+        orders += start[i];
+        revenue += amount[i];
+        units += quantity[i];
+    }
+    t.orders += orders;
+    t.revenue += revenue;
+    t.quantity += units;
+    for (size_t i = lo; i < hi; ++i) {
+        t.hourOrders[hour[i]] += start[i];
+        t.hourRevenue[hour[i]] += amount[i];
+    }
+    for (size_t i = lo; i < hi; ++i) {
+        t.categoryRevenue[category[i]] += amount[i];
+        t.categoryQuantity[category[i]] += quantity[i];
+    }
+    Money* itemRevenue = t.itemRevenue.data();
+    Quantity* itemQuantity = t.itemQuantity.data();
+    for (size_t i = lo; i < hi; ++i) {
+        itemRevenue[item[i]] += amount[i];
+        itemQuantity[item[i]] += quantity[i];
+    }
+}
+
+// Rows of c created in [from, to), found by binary search on the epoch column.
+pair<size_t, size_t> salesRange(const SalesColumns& c, int64_t from, int64_t to) {
+    size_t lo = lower_bound(c.epoch.begin(), c.epoch.end(), from) - c.epoch.begin();
+    size_t hi = lower_bound(c.epoch.begin() + lo, c.epoch.end(), to) - c.epoch.begin();
+    return make_pair(lo, hi);
+}
+
+struct ItemTotal {
+    string name;
+    Category category;
+    Quantity quantity;
+    Money revenue;
+};
+
+struct SalesReport {
+    SalesTotals totals;
+    vector<ItemTotal> topItems;    // best revenue first
+    size_t rowsScanned = 0;
+};
+
+// archive/<date>.col layout (native byte order): ColumnFileHeader, a
+// dictionary of "category,item name" lines (dictBytes long), then the
+// epoch, amount, quantity, item and ticketStart columns, rows entries each.
+// Item indexes refer to dictionary lines, so the file does not depend on
+// session item IDs.
+const char COLUMN_MAGIC[4] = {'O', 'R', 'D', 'C'};
+const uint32_t COLUMN_VERSION = 1;
+
+struct ColumnFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t rows;
+    uint32_t dictCount;
+    uint32_t dictBytes;
+};
+static_assert(sizeof(ColumnFileHeader) == 24, "column file header must stay 24 bytes");
+
+// archive/<date>.dat, a sealed (read-only) closed business day:
+// DayFileHeader, then a body of varints: the dictionary (dictCount
+// length-prefixed strings: customers and item names), then per order, in
+// time order: zigzag ID delta, time delta, status | kitchen << 4, customer
+// index, line count, and per line item index, category, zigzag quantity and
+// zigzag unit price. Totals are recomputed on read. checksum is FNV-1a of
+// the body. A typical ticket takes 10-15 bytes against ~65 in CSV.
+const char DAY_MAGIC[4] = {'O', 'R', 'D', 'A'};
+const uint32_t DAY_VERSION = 1;
+
+struct DayFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t orderCount;
+    uint32_t dictCount;
+    uint32_t bodyBytes;
+    uint32_t checksum;
+};
+static_assert(sizeof(DayFileHeader) == 24, "day file header must stay 24 bytes");
+
+void putVarint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(const char*& p, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*p++);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+uint32_t fnv1a(const char* data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// One kitchen display event, rendered when the order core queued it.
+// queuedNs is steady-clock time, for enqueue-to-display latency.
+struct KitchenEvent {
+    enum Kind : uint8_t { New, Changed, Cancelled };
+    int orderId;
+    Kind kind;
+    int64_t queuedNs;
+    string text;
+};
+
+// Bounded ring carrying kitchen events from the order core to the chef's
+// display. Producers are serialized by the store's write lock and there is
+// one display, so head and tail are the only shared state and neither side
+// blocks. A full ring drops the event and counts it; the display reloads
+// the open tickets when it starts. Every push also writes a byte to a
+// non-blocking pipe so the display can poll() instead of rescanning.
+class KitchenFeed {
+public:
+    KitchenFeed() : slots(KITCHEN_FEED_CAPACITY), head(0), tail(0), dropped(0) {
+        wake[0] = wake[1] = -1;
+        if (pipe(wake) == 0) {
+            fcntl(wake[0], F_SETFL, fcntl(wake[0], F_GETFL) | O_NONBLOCK);
+            fcntl(wake[1], F_SETFL, fcntl(wake[1], F_GETFL) | O_NONBLOCK);
+        }
+    }
+
+    ~KitchenFeed() {
+        if (wake[0] >= 0) close(wake[0]);
+        if (wake[1] >= 0) close(wake[1]);
+    }
+
+    KitchenFeed(const KitchenFeed&) = delete;
+    KitchenFeed& operator=(const KitchenFeed&) = delete;
+
+    bool push(KitchenEvent& event) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) >= slots.size()) {
+            dropped.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+        event.queuedNs = steadyNanos();
+        slots[t % slots.size()] = move(event);
+        tail.store(t + 1, memory_order_release);
+        char byte = 1;
+        if (wake[1] >= 0 && write(wake[1], &byte, 1) < 0) {
+            // Pipe full: the display already has a wakeup pending.
+        }
+        return true;
+    }
+
+    bool pop(KitchenEvent& event) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) return false;
+        event = move(slots[h % slots.size()]);
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    // Readable whenever events may be waiting; call drainWake() before
+    // popping so no wakeup is lost.
+    int wakeFd() const { return wake[0]; }
+
+    void drainWake() {
+        char buf[256];
+        while (wake[0] >= 0 && read(wake[0], buf, sizeof(buf)) > 0) {}
+    }
+
+    // Events lost to a full ring since the last call.
+    size_t takeDropped() { return dropped.exchange(0, memory_order_relaxed); }
+
+private:
+    vector<KitchenEvent> slots;
+    atomic<size_t> head;
+    atomic<size_t> tail;
+    atomic<size_t> dropped;
+    int wake[2];
+};
+
+struct Feedback {
+    int orderId;
+    string message;
+    string timestamp;
+};
+
+// A stored feedback; the text lives in the store's arena.
+struct FeedbackRecord {
+    int orderId;
+    uint32_t messageLen;
+    uint32_t timestampLen;
+    const char* message;
+    const char* timestamp;
+};
+
+// Feedback in arrival order in one array, with an order-ID index and an
+// inverted index from each word of the message to the entries containing
+// it. Entries are only appended, so every posting list stays sorted.
+// Message and timestamp text is packed into an arena.
+class FeedbackStore {
+public:
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    const FeedbackRecord& operator[](size_t slot) const { return entries[slot]; }
+
+    Feedback feedback(size_t slot) const {
+        const FeedbackRecord& r = entries[slot];
+        Feedback fb;
+        fb.orderId = r.orderId;
+        fb.message.assign(r.message, r.messageLen);
+        fb.timestamp.assign(r.timestamp, r.timestampLen);
+        return fb;
+    }
+
+    // Heap bytes held by the records and their text (indexes excluded).
+    size_t bytesReserved() const {
+        return entries.capacity() * sizeof(FeedbackRecord) + text.bytesReserved();
+    }
+
+    void add(const Feedback& fb) {
+        add(fb.orderId, fb.timestamp.data(), fb.timestamp.size(), fb.message.data(), fb.message.size());
+    }
+
+    void add(int orderId, const char* timestamp, size_t timestampLen, const char* message, size_t messageLen) {
+        uint32_t slot = static_cast<uint32_t>(entries.size());
+        FeedbackRecord r;
+        r.orderId = orderId;
+        r.messageLen = static_cast<uint32_t>(messageLen);
+        r.timestampLen = static_cast<uint32_t>(timestampLen);
+        r.message = text.copy(message, messageLen);
+        r.timestamp = text.copy(timestamp, timestampLen);
+        entries.push_back(r);
+        byOrder[orderId].push_back(slot);
+        wordsOf(r.message, messageLen, words);
+        for (const string& word : words) {
+            vector<uint32_t>& postings = byWord[word];
+            if (postings.empty() || postings.back() != slot) postings.push_back(slot);
+        }
+    }
+
+    // Entries for one order, oldest first.
+    const vector<uint32_t>& forOrder(int orderId) const {
+        static const vector<uint32_t> none;
+        auto it = byOrder.find(orderId);
+        return it == byOrder.end() ? none : it->second;
+    }
+
+    // Entries whose message contains every word of the query, oldest
+    // first. Starts from the rarest word and intersects the others into it.
+    vector<uint32_t> search(const string& query) const {
+        vector<string> terms;
+        wordsOf(query.data(), query.size(), terms);
+        vector<const vector<uint32_t>*> lists;
+        for (const string& term : terms) {
+            auto it = byWord.find(term);
+            if (it == byWord.end()) return vector<uint32_t>();
+            lists.push_back(&it->second);
+        }
+        if (lists.empty()) return vector<uint32_t>();
+        sort(lists.begin(), lists.end(),
+             [](const vector<uint32_t>* a, const vector<uint32_t>* b) { return a->size() < b->size(); });
+        vector<uint32_t> result(*lists[0]), merged;
+        for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+            merged.clear();
+            set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(),
+                             back_inserter(merged));
+            result.swap(merged);
+        }
+        return result;
+    }
+
+    // Lower-cased runs of letters and digits. Bytes of multi-byte UTF-8
+    // characters count as letters, so Amharic words are indexed whole.
+    static void wordsOf(const char* text, size_t len, vector<string>& out) {
+        out.clear();
+        string word;
+        for (size_t i = 0; i < len; ++i) {
+            unsigned char u = static_cast<unsigned char>(text[i]);
+            if (isalnum(u) || u >= 0x80) {
+                word.push_back(static_cast<char>(tolower(u)));
+            } else if (!word.empty()) {
+                out.push_back(word);
+                word.clear();
+            }
+        }
+        if (!word.empty()) out.push_back(word);
+    }
+
+private:
+    vector<FeedbackRecord> entries;
+    Arena text;
+    unordered_map<int, vector<uint32_t>> byOrder;
+    unordered_map<string, vector<uint32_t>> byWord;
+    vector<string> words;  // scratch for add
+};
+
+struct MenuEntry {
+    int id;          // 0 for an unused slot
+    Category category;
+    Money price;
+    string name;
+
+    MenuEntry() : id(0), category(Category::Other), price(0) {}
+};
+
+// One published version of the menu. A snapshot is never changed after it
+// is published: updateMenu edits a copy and swaps the pointer, so a reader
+// that loaded the old pointer keeps a consistent menu until it lets go.
+// compile() turns the editable items into the tables readers use: a dense
+// array indexed by item ID, the IDs of each category in menu order, and the
+// menu screen text.
+struct MenuSnapshot {
+    uint32_t version;
+    map<int, pair<string, pair<string, Money>>> items; // ID -> (name, (category, price)), as in menu.txt
+    vector<MenuEntry> entries;                         // indexed by item ID
+    vector<int> categoryIds[CATEGORY_COUNT];
+    string listing;
+    unordered_map<string, int> idByName;
+
+    MenuSnapshot() : version(0) {}
+
+    const MenuEntry* find(int id) const {
+        if (id <= 0 || static_cast<size_t>(id) >= entries.size() || entries[id].id == 0) return nullptr;
+        return &entries[id];
+    }
+
+    void compile() {
+        entries.assign(items.empty() ? 0 : items.rbegin()->first + 1, MenuEntry());
+        for (vector<int>& ids : categoryIds) ids.clear();
+        idByName.clear();
+        for (const auto& item : items) {
+            MenuEntry& e = entries[item.first];
+            e.id = item.first;
+            e.category = parseCategory(item.second.second.first);
+            e.price = item.second.second.second;
+            e.name = item.second.first;
+            categoryIds[static_cast<size_t>(e.category)].push_back(e.id);
+            idByName.emplace(e.name, e.id);
+        }
+
+        ostringstream out;
+        const Category shown[] = {Category::Food, Category::Drink};
+        const char* const titles[] = {"\n----- FOOD MENU -----\n", "\n----- DRINK MENU -----\n"};
+        for (size_t i = 0; i < 2; ++i) {
+            out << titles[i];
+            for (int id : categoryIds[static_cast<size_t>(shown[i])]) {
+                const MenuEntry& e = entries[id];
+                out << e.id << ". " << left << setw(20) << e.name << ": " << formatMoney(e.price) << " birr\n";
+            }
+        }
+        out << "------------------------\n";
+        listing = out.str();
+    }
+};
+
+typedef shared_ptr<const MenuSnapshot> MenuRef;
+
+typedef unordered_map<int, size_t, hash<int>, equal_to<int>, PoolAllocator<pair<const int, size_t>>> SlotIndex;
+typedef set<int, less<int>, PoolAllocator<int>> TicketSet;
+
+class OrderManager {
+private:
+    vector<Order> orders;               // contiguous order table, in insertion order
+    SlabPool slotPool;                  // hash nodes of orderSlot
+    SlotIndex orderSlot;                // order id -> index into orders
+    vector<pair<int64_t, uint32_t>> timeIndex; // (createdAt, slot), ascending
+    bool deferTimeIndex;                // bulk load in progress; index rebuilt afterwards
+    FeedbackStore feedbacks;
+    MenuRef menu;          // published snapshot; swapped under the write lock, read lock-free via currentMenu
+    mutex menuEditMutex;   // one menu editor at a time
+    unordered_map<int, pair<string, Category>> retiredItems; // negative ID -> item no longer on the menu
+    unordered_map<string, int> retiredIdByName;
+    int nextId;
+    int orderCount;        // live orders that are not deleted
+    size_t memoryBudget;   // bytes the live order store may use
+    size_t orderCapacity;  // live orders that fit in memoryBudget
+    string liveDay;        // business day held in the live set
+    vector<pair<string, int>> archivedDays;     // (day, highest order ID), oldest first
+    map<string, DaySales> dailySales;           // per-day totals, kept in step with every mutation
+    map<string, CustomerHistory> customers;     // lower-cased customer name -> live orders; sorted for prefix search
+    unordered_map<int, Quantity> foodUnits;     // all-time food units sold per item ID
+    set<pair<Quantity, int>> foodRanking;       // (-units, item ID), best seller first
+    SlabPool kitchenPool;  // tree nodes of kitchenOpen
+    TicketSet kitchenOpen; // pending and cooking tickets, oldest ID first
+    SalesColumns salesHistory;  // archived days, loaded on first report
+    SalesColumns salesLive;     // live set, rebuilt when salesVersion moves
+    atomic<bool> historyLoaded;
+    uint64_t salesVersion;      // bumped by every recordSale
+    uint64_t liveColumnsVersion;
+    unordered_map<int, uint16_t> salesCodeByItem;
+    vector<int> salesItemByCode;
+    KitchenFeed kitchenFeed;
+    int journalFd;
+    int feedbackFd;
+    int journalRecords;
+    bool csvStale;         // orders.txt export lags the live set
+    const string fileName = "orders.txt";
+    const string snapshotFileName = "orders.bin";
+    const string journalFileName = "orders.journal";
+    const string archiveDir = "archive";
+    const string archiveIndexFile = "archive/index.txt";
+    const string feedbackFileName = "feedbacks.txt";
+    const string passwordFile = "password.txt";
+    const string chefPasswordFile = "chef_password.txt";
+    const string menuFile = "menu.txt";
+    string cashierPassword;
+    string chefPassword;
+    mutable RwLock storeLock;    // orders, menu, aggregates and order persistence
+    mutable mutex analyticsMutex; // live columns and the item dictionary
+    mutable mutex feedbackMutex; // feedback store and feedbacks.txt
+    mutable mutex authMutex;     // passwords
+    mutable Metrics metrics;     // operation timings; lock-free
+    GroupCommit journal;         // batched journal writes and fsyncs
+    GroupCommit feedbackLog;     // feedbacks.txt appends; a failure sticks until restart
+    const string metricsFile = "metrics.prom";
+    int metricsInterval;         // seconds between metricsFile writes, 0 = never
+    thread metricsThread;
+    mutex metricsWakeMutex;
+    condition_variable metricsWake;
+    bool stopping;
+
+    void metricsLoop() {
+        unique_lock<mutex> lock(metricsWakeMutex);
+        while (!metricsWake.wait_for(lock, chrono::seconds(metricsInterval), [this] { return stopping; })) {
+            lock.unlock();
+            writeMetrics();
+            lock.lock();
+        }
+    }
+
+    string currentTime() const {
+        time_t t = time(nullptr);
+        tm lt;
+        localtime_r(&t, &lt);
+        char buf[20];
+        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &lt);
+        return string(buf);
+    }
+    
+    void loadPasswords() {
+        ifstream fin(passwordFile);
+        if (fin) {
+            getline(fin, cashierPassword);
+        } else {
+            cashierPassword = "123";
+            savePassword();
+        }
+
+        ifstream chefFin(chefPasswordFile);
+        if (chefFin) {
+            getline(chefFin, chefPassword);
+        } else {
+            chefPassword = "123";
+            saveChefPassword();
+        }
+    }
+
+    void savePassword() const {
+        AtomicFile file(passwordFile, &metrics);
+        file.stream() << cashierPassword;
+        if (!file.commit()) cout << "Warning: could not write " << passwordFile << ".\n";
+    }
+
+    void saveChefPassword() const {
+        AtomicFile file(chefPasswordFile, &metrics);
+        file.stream() << chefPassword;
+        if (!file.commit()) cout << "Warning: could not write " << chefPasswordFile << ".\n";
+    }
+
+    void loadMenu() {
+        shared_ptr<MenuSnapshot> loaded = make_shared<MenuSnapshot>();
+        ifstream min(menuFile);
+        if (min) {
+            string line;
+            while (getline(min, line)) {
+                if (line.empty()) continue;
+                if (line[0] == '#') {
+                    unsigned version;
+                    if (sscanf(line.c_str(), "# menu version %u", &version) == 1) loaded->version = version;
+                    continue;
+                }
+                stringstream ss(line);
+                string idStr, name, category, priceStr;
+                getline(ss, idStr, ',');
+                getline(ss, name, ',');
+                getline(ss, category, ',');
+                getline(ss, priceStr);
+                int id = stoi(idStr);
+                if (id <= 0 || id > MAX_MENU_ID) continue;
+                Money price;
+                if (!parseFixed(priceStr, MONEY_DIGITS, price)) continue;
+                loaded->items[id] = {name, {category, price}};
+            }
+            if (loaded->version == 0) loaded->version = 1;
+            loaded->compile();
+        } else {
+            loaded->version = 1;
+            loaded->items[1] = {"TIBS", {"food", 50000}};
+            loaded->items[2] = {"KITFO", {"food", 60000}};
+            loaded->items[3] = {"DORO WOTIE", {"food", 105000}};
+            loaded->items[4] = {"MINERAL WATER", {"drink", 3000}};
+            loaded->items[5] = {"BEER", {"drink", 12000}};
+            loaded->compile();
+            saveMenu(*loaded);
+        }
+        atomic_store(&menu, MenuRef(loaded));
+    }
+
+    // The published menu, for readers that do not hold the store lock.
+    MenuRef currentMenu() const {
+        return atomic_load(&menu);
+    }
+
+    // Publishes an edited copy as the next version. Only the pointer swap
+    // runs under the write lock; code holding the store lock reads menu
+    // directly, everyone else through currentMenu.
+    void publishMenu(const shared_ptr<MenuSnapshot>& next) {
+        next->version = menu->version + 1;
+        next->compile();
+        {
+            WriteGuard guard(storeLock);
+            atomic_store(&menu, MenuRef(next));
+        }
+        saveMenu(*next);
+    }
+
+    // Maps an item name from a CSV row or archive summary to an item ID.
+    int resolveItem(const string& name, Category category) {
+        auto it = menu->idByName.find(name);
+        if (it != menu->idByName.end()) return it->second;
+        auto retired = retiredIdByName.find(name);
+        if (retired != retiredIdByName.end()) return retired->second;
+        int id = -static_cast<int>(retiredItems.size()) - 1;
+        retiredItems[id] = {name, category};
+        retiredIdByName[name] = id;
+        return id;
+    }
+
+    const string& itemName(int itemId) const {
+        static const string unknown = "[UNKNOWN]";
+        const MenuEntry* item = menu->find(itemId);
+        if (item) return item->name;
+        auto retired = retiredItems.find(itemId);
+        if (retired != retiredItems.end()) return retired->second.first;
+        return unknown;
+    }
+
+    // One name per line item; a deleted ticket shows as a single [DELETED].
+    vector<string> itemNames(const Order& o) const {
+        if (o.status == OrderStatus::Deleted) return vector<string>(1, "[DELETED]");
+        vector<string> names;
+        names.reserve(o.lines.size());
+        for (const OrderLine& line : o.lines) {
+            names.push_back(itemName(line.itemId));
+        }
+        return names;
+    }
+
+    void saveMenu(const MenuSnapshot& snapshot) const {
+        AtomicFile file(menuFile, &metrics);
+        ofstream& mout = file.stream();
+        mout << "# menu version " << snapshot.version << '\n';
+        for (const auto& item : snapshot.items) {
+            mout << item.first << ',' << item.second.first << ',' 
+                 << item.second.second.first << ',' << formatMoney(item.second.second.second) << '\n';
+        }
+        if (!file.commit()) cout << "Warning: could not write " << menuFile << ".\n";
+    }
+
+    // CSV rows, one per line item, each ending in a newline. Rows of one
+    // ticket share ID, customer and time; Total is the line total. A deleted
+    // ticket is a single [DELETED] row.
+    string formatOrderRows(const Order& o) const {
+        ostringstream out;
+        string time = formatTime(o.createdAt);
+        if (o.status == OrderStatus::Deleted) {
+            out << o.id << "," << o.customer << ",[DELETED],other,0.00,0.00," << time << ",0.00\n";
+            return out.str();
+        }
+        for (const OrderLine& line : o.lines) {
+            out << o.id << "," << o.customer << "," << itemName(line.itemId) << ","
+                << categoryName(line.category) << "," << formatQuantity(line.quantity) << ","
+                << formatMoney(lineAmount(line.quantity, line.unitPrice)) << "," << time << ","
+                << formatMoney(line.unitPrice) << "\n";
+        }
+        return out.str();
+    }
+
+    // Scans one CSV row without allocating or throwing. Safe to run on
+    // several threads at once: it only reads the menu, and items that are
+    // not on it are left for resolveRow. key is the caller's scratch string.
+    bool scanOrderRow(const TextRange& text, CsvOrderRow& row, TimeParser& times, string& key) const {
+        FieldScanner fields(text, ',');
+        TextRange field;
+        if (!fields.next(field) || !parseInt(field, row.id)) return false;
+        if (!fields.next(row.customer) || !fields.next(row.item) || !fields.next(field)) return false;
+        row.category = parseCategory(field.first, rangeSize(field));
+        row.deleted = rangeSize(row.item) == 9 && memcmp(row.item.first, "[DELETED]", 9) == 0;
+        row.itemId = 0;
+        if (!row.deleted) {
+            key.assign(row.item.first, rangeSize(row.item));
+            auto it = menu->idByName.find(key);
+            if (it != menu->idByName.end()) row.itemId = it->second;
+        }
+        if (!fields.next(field) || !parseFixed(field.first, rangeSize(field), QUANTITY_DIGITS, row.quantity)) return false;
+        if (!fields.next(field) || !parseFixed(field.first, rangeSize(field), MONEY_DIGITS, row.lineTotal)) return false;
+        if (!fields.next(field) || !times.parse(field.first, rangeSize(field), row.createdAt)) return false;
+        row.hasUnitPrice = fields.rest(field) && field.first != field.second;
+        if (row.hasUnitPrice && !parseFixed(field.first, rangeSize(field), MONEY_DIGITS, row.unitPrice)) return false;
+        return true;
+    }
+
+    // Turns a scanned row into the ticket fields of o and one line item.
+    // Rows written before unit prices were kept have no UnitPrice column; it
+    // is derived from the line total. CSV has no kitchen state, so imported
+    // orders count as served.
+    void resolveRow(const CsvOrderRow& row, Order& o, OrderLine& line) {
+        o.id = row.id;
+        o.customer.assign(row.customer.first, rangeSize(row.customer));
+        o.createdAt = row.createdAt;
+        o.kitchen = KitchenState::Ready;
+        o.status = row.deleted ? OrderStatus::Deleted : OrderStatus::Active;
+        line.category = row.category;
+        line.itemId = row.itemId;
+        if (!row.deleted && line.itemId == 0) {
+            line.itemId = resolveItem(string(row.item.first, rangeSize(row.item)), line.category);
+        }
+        line.quantity = row.quantity;
+        line.unitPrice = row.hasUnitPrice ? row.unitPrice
+                       : line.quantity > 0 ? (row.lineTotal * QUANTITY_ONE + line.quantity / 2) / line.quantity : 0;
+    }
+
+    bool parseOrderRow(const string& text, Order& o, OrderLine& line) {
+        CsvOrderRow row;
+        TimeParser times;
+        string key;
+        if (!scanOrderRow(TextRange(text.data(), text.data() + text.size()), row, times, key)) return false;
+        resolveRow(row, o, line);
+        return true;
+    }
+
+    // Scans the file in newline-aligned chunks on one thread per core, then
+    // stitches the rows in file order; consecutive rows with the same ID are
+    // the lines of one ticket. Malformed rows are skipped.
+    void loadCsv(const string& path, int& maxId) {
+        MappedFile file(path);
+        const char* body = file.begin();
+        if (!body) return;
+        const char* header = static_cast<const char*>(memchr(body, '\n', static_cast<size_t>(file.end() - body)));
+        if (!header) return;
+        vector<TextRange> chunks = splitLines(header + 1, file.end());
+        vector<vector<CsvOrderRow>> scanned(chunks.size());
+        parseChunks(chunks, [&](size_t i, TextRange chunk) {
+            LineScanner lines(chunk);
+            TimeParser times;
+            string key;
+            TextRange text;
+            CsvOrderRow row;
+            scanned[i].reserve(rangeSize(chunk) / 48);
+            while (lines.next(text)) {
+                if (text.first != text.second && scanOrderRow(text, row, times, key)) scanned[i].push_back(row);
+            }
+        });
+
+        size_t rows = 0;
+        for (const vector<CsvOrderRow>& chunk : scanned) rows += chunk.size();
+        orders.reserve(orders.size() + rows);
+        orderSlot.reserve(orders.size() + rows);
+        Order pending;
+        bool havePending = false;
+        for (vector<CsvOrderRow>& chunk : scanned) {
+            for (const CsvOrderRow& row : chunk) {
+                Order o;
+                OrderLine line;
+                resolveRow(row, o, line);
+                if (!havePending || o.id != pending.id) {
+                    if (havePending) addLoadedOrder(pending, maxId);
+                    pending = std::move(o);
+                    havePending = true;
+                }
+                if (!row.deleted && pending.lines.size() < MAX_TICKET_LINES) {
+                    pending.lines.push_back(line);
+                    pending.total = ticketTotal(pending);
+                }
+            }
+            vector<CsvOrderRow>().swap(chunk);
+        }
+        if (havePending) addLoadedOrder(pending, maxId);
+    }
+
+    void addLoadedOrder(Order& o, int& maxId) {
+        if (o.status == OrderStatus::Deleted) o.total = 0;
+        appendOrder(o);
+        recordSale(o, 1);
+        maxId = max(maxId, o.id);
+        if (o.status == OrderStatus::Active) orderCount++;
+    }
+
+    // Maps orders.bin read-only and decodes the fixed-width records in place;
+    // no text parsing happens on this path. Returns false if there is no
+    // usable snapshot.
+    bool loadSnapshot(int& maxId) {
+        int fd = open(snapshotFileName.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+            close(fd);
+            cout << "Warning: " << snapshotFileName << " is truncated, ignoring it.\n";
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) return false;
+
+        const char* base = static_cast<const char*>(mapped);
+        SnapshotHeader header;
+        memcpy(&header, base, sizeof(header));
+        size_t recordBytes = header.recordCount * sizeof(OrderRecord);
+        size_t lineBytes = header.lineCount * sizeof(LineRecord);
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != SNAPSHOT_VERSION ||
+            size != sizeof(header) + recordBytes + lineBytes + header.poolSize) {
+            munmap(mapped, size);
+            cout << "Warning: " << snapshotFileName << " is not a valid snapshot, ignoring it.\n";
+            return false;
+        }
+        madvise(mapped, size, MADV_SEQUENTIAL);
+
+        const OrderRecord* records = reinterpret_cast<const OrderRecord*>(base + sizeof(header));
+        const LineRecord* lines = reinterpret_cast<const LineRecord*>(base + sizeof(header) + recordBytes);
+        const char* pool = base + sizeof(header) + recordBytes + lineBytes;
+        orders.reserve(orders.size() + header.recordCount);
+        orderSlot.reserve(orders.size() + header.recordCount);
+        for (uint64_t i = 0; i < header.recordCount; ++i) {
+            const OrderRecord& r = records[i];
+            if (r.customerOff + r.customerLen > header.poolSize ||
+                static_cast<uint64_t>(r.firstLine) + r.lineCount > header.lineCount) {
+                continue;
+            }
+            Order o;
+            o.id = r.id;
+            o.status = static_cast<OrderStatus>(r.status);
+            o.kitchen = static_cast<KitchenState>(r.kitchen);
+            o.total = r.total;
+            o.createdAt = r.createdAt;
+            o.menuVersion = r.menuVersion;
+            o.customer.assign(pool + r.customerOff, r.customerLen);
+            o.lines.reserve(r.lineCount);
+            for (uint32_t j = 0; j < r.lineCount; ++j) {
+                const LineRecord& l = lines[r.firstLine + j];
+                if (l.itemOff + l.itemLen > header.poolSize) continue;
+                OrderLine line;
+                line.category = static_cast<Category>(l.category);
+                line.itemId = l.itemId;
+                if (!menu->find(line.itemId)) {
+                    line.itemId = resolveItem(string(pool + l.itemOff, l.itemLen), line.category);
+                }
+                line.quantity = l.quantity;
+                line.unitPrice = l.unitPrice;
+                o.lines.push_back(line);
+            }
+            addLoadedOrder(o, maxId);
+        }
+        munmap(mapped, size);
+        return true;
+    }
+
+    // Loads orders.bin, or orders.txt when no snapshot exists yet, then
+    // replays the journal. Returns true if the snapshot should be rewritten.
+    bool loadFromFile() {
+        OpTimer timer(metrics, Metric::StartupLoad);
+        int maxId = 1000;
+        deferTimeIndex = true;
+        bool fromCsv = !loadSnapshot(maxId);
+        if (fromCsv) loadCsv(fileName, maxId);
+        replayJournal(maxId);
+        deferTimeIndex = false;
+        rebuildTimeIndex();
+        maxId = max(maxId, loadArchiveIndex());
+        sealLegacyDays();
+        loadArchivedSales();
+        nextId = maxId + 1;
+        return fromCsv && !orders.empty();
+    }
+
+    // Re-applies mutations recorded since the last snapshot. Records are
+    // idempotent, so a crash between snapshot rename and journal truncation
+    // is harmless. A torn final record (no trailing newline) is dropped and
+    // cut off the file so the next append starts on a fresh line; malformed
+    // records are skipped.
+    void replayJournal(int& maxId) {
+        ifstream jin(journalFileName);
+        if (!jin) return;
+        string line;
+        off_t complete = 0;  // bytes up to the end of the last whole record
+        int malformed = 0;
+        bool torn = false;
+        while (getline(jin, line)) {
+            if (jin.eof()) {
+                torn = true;
+                break;
+            }
+            complete += static_cast<off_t>(line.size()) + 1;
+            if (line.size() < 3 || line[1] != ',') continue;
+            char op = line[0];
+            string rest = line.substr(2);
+            if (op == 'D') {
+                int id;
+                if (!parseInt(rest, id)) {
+                    malformed++;
+                    continue;
+                }
+                Order* o = findOrder(id);
+                if (o && o->status == OrderStatus::Active) {
+                    recordSale(*o, -1);
+                    markDeleted(*o);
+                    orderCount--;
+                }
+            } else if (op == 'K') {
+                // K records are "<id>,<kitchen state>"
+                size_t comma = rest.find(',');
+                int id, state;
+                if (comma == string::npos || !parseInt(rest.substr(0, comma), id) ||
+                    !parseInt(rest.substr(comma + 1), state) || state < 0 ||
+                    state > static_cast<int>(KitchenState::Ready)) {
+                    malformed++;
+                    continue;
+                }
+                Order* o = findOrder(id);
+                if (o && o->status == OrderStatus::Active) {
+                    setKitchenState(*o, static_cast<KitchenState>(state));
+                }
+            } else if (op == 'C' || op == 'U') {
+                Order rec;
+                if (!parseTicketRecord(rest, rec)) {
+                    malformed++;
+                    continue;
+                }
+                Order* o = findOrder(rec.id);
+                if (o) {
+                    if (o->status == OrderStatus::Deleted) orderCount++;
+                    recordSale(*o, -1);
+                    rec.kitchen = o->kitchen;
+                    *o = rec;
+                    setKitchenState(*o, o->kitchen);
+                } else {
+                    appendOrder(rec);
+                    orderCount++;
+                }
+                recordSale(rec, 1);
+                maxId = max(maxId, rec.id);
+            }
+            journalRecords++;
+        }
+        jin.close();
+        if (malformed > 0) {
+            cout << "Warning: skipped " << malformed << " malformed record(s) in " << journalFileName << ".\n";
+        }
+        if (torn && truncate(journalFileName.c_str(), complete) != 0) {
+            cout << "Warning: could not drop the torn record at the end of " << journalFileName << ".\n";
+        }
+    }
+
+    // "D,<id>", "K,<id>,<kitchen state>" or, for C/U, the whole ticket on one line:
+    // "<op>,<id>,<epoch>,<customer>,<line count>" followed by
+    // ",<itemId>,<category>,<quantity>,<unit price>,<item>" per line, with
+    // quantity in thousandths and the price in santim, then ",<menu version>".
+    string journalRecord(char op, const Order& o) const {
+        ostringstream out;
+        out << op << ',' << o.id;
+        if (op != 'D') {
+            out << ',' << o.createdAt << ',' << o.customer << ',' << o.lines.size();
+            for (const OrderLine& line : o.lines) {
+                out << ',' << line.itemId << ',' << categoryName(line.category) << ','
+                    << line.quantity << ',' << line.unitPrice << ',' << itemName(line.itemId);
+            }
+            out << ',' << o.menuVersion;
+        }
+        out << '\n';
+        return out.str();
+    }
+
+    // Inverse of journalRecord for C/U records, without the op prefix. The
+    // item name is only used when the ID is no longer on the menu.
+    bool parseTicketRecord(const string& rec, Order& o) {
+        stringstream ss(rec);
+        string field;
+        int count;
+        if (!getline(ss, field, ',') || !parseInt(field, o.id)) return false;
+        if (!getline(ss, field, ',') || !parseFixed(field, 0, o.createdAt)) return false;
+        if (!getline(ss, o.customer, ',')) return false;
+        if (!getline(ss, field, ',') || !parseInt(field, count)) return false;
+        if (count <= 0 || static_cast<size_t>(count) > MAX_TICKET_LINES) return false;
+        o.status = OrderStatus::Active;
+        o.kitchen = KitchenState::Pending;
+        o.lines.clear();
+        for (int i = 0; i < count; ++i) {
+            string idText, category, quantity, price, item;
+            OrderLine line;
+            if (!getline(ss, idText, ',') || !parseInt(idText, line.itemId) || !getline(ss, category, ',') ||
+                !getline(ss, quantity, ',') || !parseFixed(quantity, 0, line.quantity) ||
+                !getline(ss, price, ',') || !parseFixed(price, 0, line.unitPrice) ||
+                !getline(ss, item, ',')) {
+                return false;
+            }
+            line.category = parseCategory(category);
+            if (!menu->find(line.itemId)) line.itemId = resolveItem(item, line.category);
+            o.lines.push_back(line);
+        }
+        // Records journaled before menus were versioned end after the last line.
+        int version = 0;
+        if (getline(ss, field, ',') && !field.empty() && (!parseInt(field, version) || version < 0)) return false;
+        o.menuVersion = static_cast<uint32_t>(version);
+        o.total = ticketTotal(o);
+        return true;
+    }
+
+    // Hands one or more journal records to the group commit and returns
+    // the sequence number to wait on (see CommitWait).
+    uint64_t writeJournal(const string& records, int count) {
+        uint64_t seq = journal.append(records);
+        csvStale = true;
+        journalRecords += count;
+        // Compaction rewrites the whole snapshot, so let the journal grow in
+        // proportion to it to keep the rewrite cost amortised O(1) per record.
+        if (journalRecords >= max(JOURNAL_COMPACT_THRESHOLD, static_cast<int>(orders.size()))) {
+            compactJournal();
+        }
+        return seq;
+    }
+
+    uint64_t appendJournal(char op, const Order& o) {
+        return writeJournal(journalRecord(op, o), 1);
+    }
+
+    // Folds the journal into a fresh orders.bin snapshot, then empties it,
+    // reopening it if the old descriptor cannot be truncated. Returns
+    // whether the snapshot was written: once it is, every change so far is
+    // on disk whatever became of the journal.
+    bool compactJournal() {
+        if (!saveToFile()) {
+            cout << "Warning: could not write " << snapshotFileName << ".\n";
+            return false;
+        }
+        if (journal.reset()) {
+            journalRecords = 0;
+            return true;
+        }
+        int fd = open(journalFileName.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            journal.reset(fd);
+            if (journalFd >= 0) close(journalFd);
+            journalFd = fd;
+            journalRecords = 0;
+        }
+        return true;
+    }
+
+    // Waits for a mutation's journal records. If the journal could not take
+    // them, a compaction puts the whole store, this change included, into
+    // a fresh snapshot instead and clears the failure; only when that fails
+    // too is the change reported as made but not saved. Nothing is undone
+    // either way, so the caller must not report the change as refused.
+    bool awaitCommit(CommitWait& commit, string& error) {
+        uint64_t seq = commit.seq;
+        if (commit.wait(error)) return true;
+        WriteGuard guard(storeLock);
+        if (!journal.isDurable(seq) && !compactJournal()) return false;
+        error.clear();
+        return true;
+    }
+
+    bool saveToFile() const {
+        OpTimer timer(metrics, Metric::SnapshotSave);
+        vector<OrderRecord> records(orders.size());
+        vector<LineRecord> lines;
+        string pool;
+        unordered_map<string, uint32_t> pooled;
+        auto intern = [&](const string& str, uint32_t& off, uint16_t& len) {
+            len = static_cast<uint16_t>(min<size_t>(str.size(), UINT16_MAX));
+            auto it = pooled.find(str);
+            if (it != pooled.end()) {
+                off = it->second;
+                return;
+            }
+            off = static_cast<uint32_t>(pool.size());
+            pool.append(str, 0, len);
+            pooled.emplace(str, off);
+        };
+        for (size_t i = 0; i < orders.size(); ++i) {
+            const Order& o = orders[i];
+            OrderRecord& r = records[i];
+            memset(&r, 0, sizeof(r));
+            r.id = o.id;
+            r.status = static_cast<uint8_t>(o.status);
+            r.kitchen = static_cast<uint8_t>(o.kitchen);
+            intern(o.customer, r.customerOff, r.customerLen);
+            r.firstLine = static_cast<uint32_t>(lines.size());
+            r.lineCount = static_cast<uint8_t>(o.lines.size());
+            r.total = o.total;
+            r.createdAt = o.createdAt;
+            r.menuVersion = o.menuVersion;
+            for (const OrderLine& line : o.lines) {
+                LineRecord l;
+                memset(&l, 0, sizeof(l));
+                l.itemId = line.itemId;
+                l.category = static_cast<uint8_t>(line.category);
+                intern(itemName(line.itemId), l.itemOff, l.itemLen);
+                l.quantity = static_cast<int32_t>(line.quantity);
+                l.unitPrice = line.unitPrice;
+                lines.push_back(l);
+            }
+        }
+
+        SnapshotHeader header;
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.recordCount = records.size();
+        header.lineCount = lines.size();
+        header.poolSize = pool.size();
+
+        AtomicFile file(snapshotFileName, &metrics, ios::binary);
+        {
+            ofstream& fout = file.stream();
+            fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            fout.write(reinterpret_cast<const char*>(records.data()),
+                       static_cast<streamsize>(records.size() * sizeof(OrderRecord)));
+            fout.write(reinterpret_cast<const char*>(lines.data()),
+                       static_cast<streamsize>(lines.size() * sizeof(LineRecord)));
+            fout.write(pool.data(), static_cast<streamsize>(pool.size()));
+            metrics.addBytes(Metric::SnapshotSave, sizeof(header) + records.size() * sizeof(OrderRecord)
+                                                   + lines.size() * sizeof(LineRecord) + pool.size());
+        }
+        return file.commit();
+    }
+
+    // Writes the live set as CSV (the orders.txt export format).
+    bool exportCsv(const string& path) const {
+        OpTimer timer(metrics, Metric::CsvExport);
+        AtomicFile file(path, &metrics);
+        {
+            ofstream& fout = file.stream();
+            fout << "ID,Customer,Item,Category,Quantity,Total,Time,UnitPrice\n";
+            for (const Order& o : orders) {
+                fout << formatOrderRows(o);
+            }
+            fout.flush();
+            metrics.addBytes(Metric::CsvExport, static_cast<uint64_t>(fout.tellp()));
+        }
+        return file.commit();
+    }
+
+    // Reads archive/index.txt into archivedDays and returns the highest
+    // order ID ever archived, so IDs stay unique once the live set no longer
+    // holds earlier days.
+    int loadArchiveIndex() {
+        archivedDays.clear();
+        int maxId = 0;
+        ifstream fin(archiveIndexFile);
+        string line;
+        while (getline(fin, line)) {
+            size_t pos = line.rfind(',');
+            int dayMax;
+            if (pos == string::npos ||
+                !parseInt(TextRange(line.data() + pos + 1, line.data() + line.size()), dayMax)) {
+                continue;
+            }
+            archivedDays.push_back(make_pair(line.substr(0, line.find(',')), dayMax));
+            maxId = max(maxId, dayMax);
+        }
+        return maxId;
+    }
+
+    // Seals one closed day into archive/<date>.dat (see DayFileHeader);
+    // the orders must be in time order.
+    bool writeDayFile(const string& day, const vector<const Order*>& dayOrders) const {
+        vector<string> dict;
+        unordered_map<string, uint32_t> dictIndex;
+        auto intern = [&](const string& text) {
+            auto it = dictIndex.find(text);
+            if (it != dictIndex.end()) return it->second;
+            uint32_t index = static_cast<uint32_t>(dict.size());
+            dict.push_back(text);
+            dictIndex.emplace(text, index);
+            return index;
+        };
+        string records;
+        int prevId = 0;
+        int64_t prevTime = 0;
+        for (const Order* o : dayOrders) {
+            putVarint(records, zigzag(static_cast<int64_t>(o->id) - prevId));
+            putVarint(records, zigzag(o->createdAt - prevTime));
+            records.push_back(static_cast<char>(static_cast<uint8_t>(o->status) |
+                                                static_cast<uint8_t>(o->kitchen) << 4));
+            putVarint(records, intern(o->customer));
+            putVarint(records, o->lines.size());
+            for (const OrderLine& line : o->lines) {
+                putVarint(records, intern(itemName(line.itemId)));
+                records.push_back(static_cast<char>(line.category));
+                putVarint(records, zigzag(line.quantity));
+                putVarint(records, zigzag(line.unitPrice));
+            }
+            prevId = o->id;
+            prevTime = o->createdAt;
+        }
+        string body;
+        for (const string& text : dict) {
+            putVarint(body, text.size());
+            body += text;
+        }
+        body += records;
+
+        DayFileHeader header;
+        memcpy(header.magic, DAY_MAGIC, sizeof(header.magic));
+        header.version = DAY_VERSION;
+        header.orderCount = static_cast<uint32_t>(dayOrders.size());
+        header.dictCount = static_cast<uint32_t>(dict.size());
+        header.bodyBytes = static_cast<uint32_t>(body.size());
+        header.checksum = fnv1a(body.data(), body.size());
+        string dayFile = archiveDir + "/" + day + ".dat";
+        AtomicFile file(dayFile, &metrics, ios::binary);
+        file.stream().write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.stream().write(body.data(), static_cast<streamsize>(body.size()));
+        chmod(file.tempPath().c_str(), 0444);
+        return file.commit();
+    }
+
+    // Reads one archived day as (order, item names), in time order. Item IDs
+    // are only resolved against the current menu (0 when the item is no
+    // longer on it), so this needs no write access. Days archived as CSV by
+    // earlier versions are read from archive/<date>.txt.
+    bool readDayFile(const string& day, vector<pair<Order, vector<string>>>& out) const {
+        MappedFile file(archiveDir + "/" + day + ".dat");
+        const char* p = file.begin();
+        if (!p) return readDayCsv(day, out);
+        DayFileHeader header;
+        if (static_cast<size_t>(file.end() - p) < sizeof(header)) return false;
+        memcpy(&header, p, sizeof(header));
+        p += sizeof(header);
+        const char* end = file.end();
+        if (memcmp(header.magic, DAY_MAGIC, sizeof(header.magic)) != 0 || header.version != DAY_VERSION ||
+            static_cast<size_t>(end - p) != header.bodyBytes || fnv1a(p, header.bodyBytes) != header.checksum) {
+            cout << "Warning: " << archiveDir << "/" << day << ".dat is damaged, skipping it.\n";
+            return false;
+        }
+        vector<string> dict(header.dictCount);
+        uint64_t value;
+        for (string& text : dict) {
+            if (!getVarint(p, end, value) || value > static_cast<uint64_t>(end - p)) return false;
+            text.assign(p, static_cast<size_t>(value));
+            p += value;
+        }
+        int64_t id = 0, createdAt = 0;
+        out.reserve(out.size() + header.orderCount);
+        for (uint32_t i = 0; i < header.orderCount; ++i) {
+            Order o;
+            uint64_t idDelta, timeDelta, customer, lineCount;
+            if (!getVarint(p, end, idDelta) || !getVarint(p, end, timeDelta) || p >= end) return false;
+            uint8_t state = static_cast<uint8_t>(*p++);
+            if (!getVarint(p, end, customer) || customer >= dict.size() ||
+                !getVarint(p, end, lineCount) || lineCount > MAX_TICKET_LINES) {
+                return false;
+            }
+            id += unzigzag(idDelta);
+            createdAt += unzigzag(timeDelta);
+            o.id = static_cast<int>(id);
+            o.createdAt = createdAt;
+            o.status = static_cast<OrderStatus>(state & 0x0f);
+            o.kitchen = static_cast<KitchenState>(state >> 4);
+            o.customer = dict[customer];
+            vector<string> names;
+            for (uint64_t j = 0; j < lineCount; ++j) {
+                OrderLine line;
+                uint64_t item, quantity, price;
+                if (!getVarint(p, end, item) || item >= dict.size() || p >= end) return false;
+                line.category = static_cast<Category>(*p++);
+                if (!getVarint(p, end, quantity) || !getVarint(p, end, price)) return false;
+                auto known = menu->idByName.find(dict[item]);
+                line.itemId = known != menu->idByName.end() ? known->second : 0;
+                line.quantity = unzigzag(quantity);
+                line.unitPrice = unzigzag(price);
+                o.lines.push_back(line);
+                names.push_back(dict[item]);
+            }
+            o.total = ticketTotal(o);
+            if (o.status == OrderStatus::Deleted) names.assign(1, "[DELETED]");
+            out.push_back(make_pair(std::move(o), std::move(names)));
+        }
+        return true;
+    }
+
+    bool readDayCsv(const string& day, vector<pair<Order, vector<string>>>& out) const {
+        MappedFile file(archiveDir + "/" + day + ".txt");
+        if (!file.begin()) return false;
+        LineScanner lines(TextRange(file.begin(), file.end()));
+        TextRange text;
+        lines.next(text);
+        TimeParser times;
+        string key;
+        CsvOrderRow row;
+        size_t first = out.size();
+        while (lines.next(text)) {
+            if (text.first == text.second || !scanOrderRow(text, row, times, key)) continue;
+            if (out.size() == first || out.back().first.id != row.id) {
+                Order o;
+                o.id = row.id;
+                o.customer.assign(row.customer.first, rangeSize(row.customer));
+                o.createdAt = row.createdAt;
+                o.kitchen = KitchenState::Ready;
+                o.status = row.deleted ? OrderStatus::Deleted : OrderStatus::Active;
+                o.total = 0;
+                out.push_back(make_pair(o, vector<string>(row.deleted ? 1 : 0, "[DELETED]")));
+            }
+            Order& o = out.back().first;
+            if (row.deleted || o.lines.size() >= MAX_TICKET_LINES) continue;
+            OrderLine line;
+            line.itemId = row.itemId;
+            line.category = row.category;
+            line.quantity = row.quantity;
+            line.unitPrice = row.hasUnitPrice ? row.unitPrice
+                           : row.quantity > 0 ? (row.lineTotal * QUANTITY_ONE + row.quantity / 2) / row.quantity : 0;
+            o.lines.push_back(line);
+            o.total = ticketTotal(o);
+            out.back().second.push_back(string(row.item.first, rangeSize(row.item)));
+        }
+        stable_sort(out.begin() + static_cast<ptrdiff_t>(first), out.end(),
+                    [](const pair<Order, vector<string>>& a, const pair<Order, vector<string>>& b) {
+                        return a.first.createdAt < b.first.createdAt;
+                    });
+        return true;
+    }
+
+    // Rewrites days archived as CSV by earlier versions into sealed .dat
+    // files, once.
+    void sealLegacyDays() {
+        for (const auto& entry : archivedDays) {
+            string csvFile = archiveDir + "/" + entry.first + ".txt";
+            struct stat st;
+            if (stat(csvFile.c_str(), &st) != 0) continue;
+            vector<pair<Order, vector<string>>> found;
+            if (!readDayCsv(entry.first, found)) continue;
+            resolveArchivedItems(found);
+            vector<const Order*> dayOrders;
+            for (const auto& item : found) dayOrders.push_back(&item.first);
+            if (writeDayFile(entry.first, dayOrders)) remove(csvFile.c_str());
+        }
+    }
+
+    // Gives archived lines whose item is no longer on the menu a session ID.
+    void resolveArchivedItems(vector<pair<Order, vector<string>>>& found) {
+        for (auto& item : found) {
+            Order& o = item.first;
+            for (size_t i = 0; i < o.lines.size(); ++i) {
+                if (o.lines[i].itemId == 0) o.lines[i].itemId = resolveItem(item.second[i], o.lines[i].category);
+            }
+        }
+    }
+
+    // Archived day whose ID range holds id; empty if none does.
+    string archivedDayOf(int id) const {
+        auto it = lower_bound(archivedDays.begin(), archivedDays.end(), id,
+                              [](const pair<string, int>& day, int wanted) { return day.second < wanted; });
+        return it == archivedDays.end() ? string() : it->first;
+    }
+
+    // Moves every order from a day before today out of the live set into a
+    // sealed archive/<date>.dat. A day that is already sealed (a back-dated
+    // import, or a rerun after a crash before the snapshot was compacted) is
+    // merged with its archive, live rows winning on equal IDs. A day whose
+    // archive cannot be read or written stays live and is retried next time.
+    void archiveClosedDays() {
+        OpTimer timer(metrics, Metric::ArchiveDays);
+        int64_t todayStart = startOfDay(time(nullptr));
+        liveDay = dayOf(todayStart);
+        map<string, vector<size_t>> closed;
+        auto end = lower_bound(timeIndex.begin(), timeIndex.end(), make_pair(todayStart, uint32_t(0)));
+        for (auto it = timeIndex.begin(); it != end; ++it) {
+            closed[dayOf(it->first)].push_back(it->second);
+        }
+        if (closed.empty()) return;
+
+        mkdir(archiveDir.c_str(), 0755);
+        map<string, string> index;
+        {
+            ifstream fin(archiveIndexFile);
+            string line;
+            while (getline(fin, line)) {
+                if (!line.empty()) index[line.substr(0, line.find(','))] = line;
+            }
+        }
+        set<string> unsealed;
+        for (const auto& day : closed) {
+            vector<pair<Order, vector<string>>> sealed;
+            if (index.count(day.first)) {
+                if (!readDayFile(day.first, sealed)) {
+                    cout << "Warning: could not read the archive for " << day.first << "; keeping its orders live.\n";
+                    unsealed.insert(day.first);
+                    continue;
+                }
+                resolveArchivedItems(sealed);
+            }
+            int maxId = 0;
+            set<int> liveIds;
+            vector<const Order*> dayOrders, merged;
+            dayOrders.reserve(day.second.size() + sealed.size());
+            for (size_t slot : day.second) {
+                dayOrders.push_back(&orders[slot]);
+                liveIds.insert(orders[slot].id);
+            }
+            for (const auto& item : sealed) {
+                if (!liveIds.count(item.first.id)) merged.push_back(&item.first);
+            }
+            if (!merged.empty()) {
+                dayOrders.insert(dayOrders.end(), merged.begin(), merged.end());
+                stable_sort(dayOrders.begin(), dayOrders.end(),
+                            [](const Order* a, const Order* b) { return a->createdAt < b->createdAt; });
+            }
+            for (const Order* o : dayOrders) maxId = max(maxId, o->id);
+            if (!writeDayFile(day.first, dayOrders)) {
+                cout << "Warning: could not archive orders for " << day.first << ".\n";
+                unsealed.insert(day.first);
+                continue;
+            }
+            // loadArchivedSales already counted the sealed-only rows of a
+            // day that still had live rows, so the totals cover the merge.
+            remove((archiveDir + "/" + day.first + ".txt").c_str());
+            saveDayColumns(day.first, dayOrders);
+            saveDaySummary(day.first);
+            index[day.first] = day.first + "," + to_string(dayOrders.size()) + "," + to_string(maxId);
+        }
+        if (unsealed.size() == closed.size()) return;
+        {
+            AtomicFile file(archiveIndexFile, &metrics);
+            for (const auto& entry : index) file.stream() << entry.second << "\n";
+            file.commit();
+        }
+        loadArchiveIndex();
+
+        size_t archived = 0;
+        vector<Order> live;
+        live.reserve(orders.size());
+        for (Order& o : orders) {
+            if (o.createdAt < todayStart && (unsealed.empty() || !unsealed.count(dayOf(o.createdAt)))) {
+                archived++;
+                if (o.status == OrderStatus::Active) orderCount--;
+            } else {
+                live.push_back(move(o));
+            }
+        }
+        orders.swap(live);
+        rebuildOrderIndex();
+        compactJournal();
+        updateCapacity();
+        historyLoaded = false;
+        salesVersion++;
+        cout << "Archived " << archived << " order(s) from " << closed.size() - unsealed.size()
+             << " closed day(s) to " << archiveDir << "/.\n";
+    }
+
+    // Adds (sign = 1) or removes (sign = -1) one order's contribution to the
+    // running per-day and per-item totals. Deleted orders contribute nothing.
+    void recordSale(const Order& o, int sign) {
+        if (o.status == OrderStatus::Deleted) return;
+        CustomerHistory& customer = customers[customerKey(o.customer)];
+        customer.orders += sign;
+        customer.spend += sign * o.total;
+        recordDaySale(o, sign);
+    }
+
+    // The per-day and per-item part of recordSale, also used for archived
+    // orders, which have no customer history.
+    void recordDaySale(const Order& o, int sign) {
+        if (o.status == OrderStatus::Deleted) return;
+        salesVersion++;
+        string day = dayOf(o.createdAt);
+        DaySales& d = dailySales[day];
+        d.orders += sign;
+        d.revenue += sign * o.total;
+        for (const OrderLine& line : o.lines) {
+            ItemSales& item = d.items[line.itemId];
+            item.category = line.category;
+            item.orders += sign;
+            item.quantity += sign * line.quantity;
+            item.revenue += sign * lineAmount(line.quantity, line.unitPrice);
+            if (item.orders <= 0) d.items.erase(line.itemId);
+            if (line.category == Category::Food) addFoodUnits(line.itemId, sign * line.quantity);
+        }
+        if (d.orders <= 0) dailySales.erase(day);
+    }
+
+    void addFoodUnits(int item, Quantity units) {
+        auto it = foodUnits.find(item);
+        Quantity before = it == foodUnits.end() ? 0 : it->second;
+        if (it != foodUnits.end()) foodRanking.erase(make_pair(-before, item));
+        Quantity after = before + units;
+        if (after > 0) {
+            foodUnits[item] = after;
+            foodRanking.insert(make_pair(-after, item));
+        } else if (it != foodUnits.end()) {
+            foodUnits.erase(it);
+        }
+    }
+
+    // archive/<date>.sum holds one line per item sold that day:
+    // category,orders,quantity,revenue,item
+    void saveDaySummary(const string& day) const {
+        auto d = dailySales.find(day);
+        if (d == dailySales.end()) return;
+        string sumFile = archiveDir + "/" + day + ".sum";
+        AtomicFile file(sumFile, &metrics);
+        for (const auto& item : d->second.items) {
+            file.stream() << categoryName(item.second.category) << ',' << item.second.orders << ','
+                          << formatQuantity(item.second.quantity) << ','
+                          << formatMoney(item.second.revenue) << ',' << itemName(item.first) << '\n';
+        }
+        file.commit();
+    }
+
+    // Seeds the running totals with archived days. A day that also has live
+    // rows (archival interrupted before compaction, or a back-dated import)
+    // is counted from its live rows plus the sealed rows whose IDs are not
+    // live, read from its day file.
+    void loadArchivedSales() {
+        ifstream idx(archiveIndexFile);
+        string line;
+        while (getline(idx, line)) {
+            string day = line.substr(0, line.find(','));
+            if (day.empty()) continue;
+            if (hasLiveRows(day)) {
+                vector<pair<Order, vector<string>>> sealed;
+                readDayFile(day, sealed);
+                resolveArchivedItems(sealed);
+                for (const auto& item : sealed) {
+                    if (!findOrder(item.first.id)) recordDaySale(item.first, 1);
+                }
+                continue;
+            }
+            ifstream fin(archiveDir + "/" + day + ".sum");
+            string row;
+            while (getline(fin, row)) {
+                stringstream ss(row);
+                string category, ordersStr, qtyStr, revenueStr, item;
+                getline(ss, category, ',');
+                getline(ss, ordersStr, ',');
+                getline(ss, qtyStr, ',');
+                getline(ss, revenueStr, ',');
+                getline(ss, item);
+                ItemSales sales = {parseCategory(category), 0, 0, 0};
+                if (item.empty() || ordersStr.empty() ||
+                    !parseFixed(qtyStr, QUANTITY_DIGITS, sales.quantity) ||
+                    !parseFixed(revenueStr, MONEY_DIGITS, sales.revenue)) {
+                    continue;
+                }
+                sales.orders = stoi(ordersStr);
+                int itemId = resolveItem(item, sales.category);
+                DaySales& d = dailySales[day];
+                d.orders += sales.orders;
+                d.revenue += sales.revenue;
+                d.items[itemId] = sales;
+                if (sales.category == Category::Food) addFoodUnits(itemId, sales.quantity);
+            }
+        }
+    }
+
+    // Whether the live set holds any order, deleted or not, from this local
+    // day; needs the time index.
+    bool hasLiveRows(const string& day) const {
+        int64_t dayStart;
+        if (!parseTime(day + " 00:00", dayStart)) return false;
+        auto it = lower_bound(timeIndex.begin(), timeIndex.end(), make_pair(dayStart, uint32_t(0)));
+        return it != timeIndex.end() && it->first < startOfDay(dayStart + 26 * 3600);
+    }
+
+    uint16_t salesCode(int itemId) {
+        auto it = salesCodeByItem.find(itemId);
+        if (it != salesCodeByItem.end()) return it->second;
+        uint16_t code = static_cast<uint16_t>(salesItemByCode.size());
+        salesItemByCode.push_back(itemId);
+        salesCodeByItem.emplace(itemId, code);
+        return code;
+    }
+
+    void appendSalesRows(SalesColumns& columns, const Order& o) {
+        if (o.status == OrderStatus::Deleted) return;
+        for (size_t i = 0; i < o.lines.size(); ++i) {
+            const OrderLine& line = o.lines[i];
+            columns.append(o.createdAt, lineAmount(line.quantity, line.unitPrice), line.quantity,
+                           salesCode(line.itemId), line.category, i == 0);
+        }
+    }
+
+    // Writes the columnar copy of one closed day; orders are in time order.
+    void saveDayColumns(const string& day, const vector<const Order*>& dayOrders) const {
+        map<int, uint16_t> dictIndex;
+        string dict;
+        vector<int64_t> epoch;
+        vector<int64_t> amount;
+        vector<int32_t> quantity;
+        vector<uint16_t> item;
+        vector<uint8_t> ticketStart;
+        for (const Order* o : dayOrders) {
+            if (o->status == OrderStatus::Deleted) continue;
+            for (size_t i = 0; i < o->lines.size(); ++i) {
+                const OrderLine& line = o->lines[i];
+                auto entry = dictIndex.find(line.itemId);
+                if (entry == dictIndex.end()) {
+                    entry = dictIndex.emplace(line.itemId, static_cast<uint16_t>(dictIndex.size())).first;
+                    dict += string(categoryName(line.category)) + "," + itemName(line.itemId) + "\n";
+                }
+                epoch.push_back(o->createdAt);
+                amount.push_back(lineAmount(line.quantity, line.unitPrice));
+                quantity.push_back(static_cast<int32_t>(line.quantity));
+                item.push_back(entry->second);
+                ticketStart.push_back(i == 0 ? 1 : 0);
+            }
+        }
+        ColumnFileHeader header;
+        memcpy(header.magic, COLUMN_MAGIC, sizeof(header.magic));
+        header.version = COLUMN_VERSION;
+        header.rows = epoch.size();
+        header.dictCount = static_cast<uint32_t>(dictIndex.size());
+        header.dictBytes = static_cast<uint32_t>(dict.size());
+        string colFile = archiveDir + "/" + day + ".col";
+        AtomicFile file(colFile, &metrics, ios::binary);
+        {
+            ofstream& fout = file.stream();
+            fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            fout.write(dict.data(), static_cast<streamsize>(dict.size()));
+            fout.write(reinterpret_cast<const char*>(epoch.data()), static_cast<streamsize>(epoch.size() * sizeof(int64_t)));
+            fout.write(reinterpret_cast<const char*>(amount.data()), static_cast<streamsize>(amount.size() * sizeof(int64_t)));
+            fout.write(reinterpret_cast<const char*>(quantity.data()), static_cast<streamsize>(quantity.size() * sizeof(int32_t)));
+            fout.write(reinterpret_cast<const char*>(item.data()), static_cast<streamsize>(item.size() * sizeof(uint16_t)));
+            fout.write(reinterpret_cast<const char*>(ticketStart.data()), static_cast<streamsize>(ticketStart.size()));
+        }
+        file.commit();
+    }
+
+    // Appends archive/<date>.col to salesHistory; false if it is missing or
+    // unreadable.
+    bool loadDayColumns(const string& day) {
+        ifstream fin(archiveDir + "/" + day + ".col", ios::binary);
+        ColumnFileHeader header;
+        if (!fin.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            memcmp(header.magic, COLUMN_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != COLUMN_VERSION) {
+            return false;
+        }
+        string dict(header.dictBytes, '\0');
+        size_t rows = header.rows;
+        vector<int64_t> epoch(rows);
+        vector<int64_t> amount(rows);
+        vector<int32_t> quantity(rows);
+        vector<uint16_t> item(rows);
+        vector<uint8_t> ticketStart(rows);
+        fin.read(&dict[0], static_cast<streamsize>(dict.size()));
+        fin.read(reinterpret_cast<char*>(epoch.data()), static_cast<streamsize>(rows * sizeof(int64_t)));
+        fin.read(reinterpret_cast<char*>(amount.data()), static_cast<streamsize>(rows * sizeof(int64_t)));
+        fin.read(reinterpret_cast<char*>(quantity.data()), static_cast<streamsize>(rows * sizeof(int32_t)));
+        fin.read(reinterpret_cast<char*>(item.data()), static_cast<streamsize>(rows * sizeof(uint16_t)));
+        fin.read(reinterpret_cast<char*>(ticketStart.data()), static_cast<streamsize>(rows));
+        if (!fin) return false;
+
+        vector<uint16_t> codes;
+        vector<Category> categories;
+        stringstream ss(dict);
+        string line;
+        while (getline(ss, line)) {
+            size_t comma = line.find(',');
+            if (comma == string::npos) return false;
+            Category category = parseCategory(line.substr(0, comma));
+            codes.push_back(salesCode(resolveItem(line.substr(comma + 1), category)));
+            categories.push_back(category);
+        }
+        if (codes.size() != header.dictCount) return false;
+        salesHistory.reserve(salesHistory.size() + rows);
+        for (size_t i = 0; i < rows; ++i) {
+            if (item[i] >= codes.size()) continue;
+            salesHistory.append(epoch[i], amount[i], quantity[i], codes[item[i]],
+                                categories[item[i]], ticketStart[i] != 0);
+        }
+        return true;
+    }
+
+    // Builds salesHistory from the archive. Days archived before column
+    // files existed are read from their day file once and get a .col
+    // written. Runs under the write lock, since unknown item names are
+    // registered.
+    void loadSalesHistory() {
+        salesHistory.clear();
+        for (const auto& entry : archivedDays) {
+            const string& day = entry.first;
+            if (day >= liveDay || loadDayColumns(day)) continue;
+            vector<pair<Order, vector<string>>> found;
+            if (!readDayFile(day, found)) continue;
+            resolveArchivedItems(found);
+            vector<const Order*> pointers;
+            for (const auto& item : found) pointers.push_back(&item.first);
+            saveDayColumns(day, pointers);
+            if (!loadDayColumns(day)) {
+                for (const Order* o : pointers) appendSalesRows(salesHistory, *o);
+            }
+        }
+        historyLoaded = true;
+    }
+
+    // Resident cost of one live order: the record itself (with up to
+    // INLINE_TICKET_LINES lines), its time-index entry and bucket, its
+    // hash node, and the average heap usage of long customer names, large
+    // tickets and the customer index. The node pool's arena grows in whole
+    // blocks, so it is charged per node rather than per block.
+    size_t bytesPerOrder() const {
+        size_t node = slotPool.blockBytes();
+        if (node == 0) node = sizeof(pair<const int, size_t>) + sizeof(void*);
+        size_t fixedCost = sizeof(Order) + sizeof(void*) + sizeof(pair<int64_t, uint32_t>) + node;
+        if (orders.empty()) return fixedCost;
+        size_t heap = 0;
+        for (const Order& o : orders) {
+            heap += stringHeapBytes(o.customer) + o.lines.heapBytes();
+        }
+        for (const auto& customer : customers) {
+            heap += sizeof(customer) + 4 * sizeof(void*) + stringHeapBytes(customer.first) +
+                    stringHeapBytes(customer.second.name) + customer.second.orderIds.capacity() * sizeof(int);
+        }
+        return fixedCost + heap / orders.size();
+    }
+
+    void configureCapacity() {
+        size_t budgetMb = DEFAULT_MEMORY_BUDGET_MB;
+        const char* env = getenv("ORDER_MEMORY_BUDGET_MB");
+        if (env && atol(env) > 0) budgetMb = static_cast<size_t>(atol(env));
+        memoryBudget = budgetMb * 1024 * 1024;
+        size_t perOrder = updateCapacity();
+        cout << "Order store: " << orders.size() << " live order(s), ~" << perOrder
+             << " bytes/order, memory budget " << budgetMb << " MB (~"
+             << orderCapacity << " orders).\n";
+    }
+
+    // Re-estimates orderCapacity from the current live set; called when the
+    // set changes wholesale (archiving, imports). Returns the per-order cost.
+    size_t updateCapacity() {
+        size_t perOrder = bytesPerOrder();
+        orderCapacity = memoryBudget / perOrder;
+        return perOrder;
+    }
+
+    void markDeleted(Order& o) {
+        o.status = OrderStatus::Deleted;
+        o.lines.clear();
+        o.total = 0;
+        kitchenOpen.erase(o.id);
+    }
+
+    void setKitchenState(Order& o, KitchenState state) {
+        o.kitchen = state;
+        if (o.status == OrderStatus::Active && state != KitchenState::Ready) {
+            kitchenOpen.insert(o.id);
+        } else {
+            kitchenOpen.erase(o.id);
+        }
+    }
+
+    // The ticket as the kitchen sees it: header line plus one line per item.
+    string renderKitchenTicket(const Order& o) const {
+        ostringstream out;
+        out << "#" << o.id << " " << o.customer << "  " << formatTime(o.createdAt).substr(11)
+            << "  [" << kitchenStateName(o.kitchen) << "]\n";
+        for (const OrderLine& line : o.lines) {
+            out << "    " << itemName(line.itemId) << " x" << formatQuantity(line.quantity) << "\n";
+        }
+        return out.str();
+    }
+
+    void queueKitchenEvent(const Order& o, KitchenEvent::Kind kind) {
+        KitchenEvent event;
+        event.orderId = o.id;
+        event.kind = kind;
+        event.text = kind == KitchenEvent::Cancelled ? string() : renderKitchenTicket(o);
+        kitchenFeed.push(event);
+    }
+
+    // Orders normally arrive in time order, so the time index is appended
+    // to; an out-of-order time is inserted at its sorted position.
+    void appendOrder(const Order& o) {
+        uint32_t slot = static_cast<uint32_t>(orders.size());
+        orderSlot.emplace(o.id, slot);
+        orders.push_back(o);
+        if (o.status == OrderStatus::Active && o.kitchen != KitchenState::Ready) {
+            kitchenOpen.insert(kitchenOpen.end(), o.id);  // IDs mostly arrive in order
+        }
+        CustomerHistory& customer = customers[customerKey(o.customer)];
+        customer.name = o.customer;
+        customer.orderIds.push_back(o.id);
+        if (deferTimeIndex) return;
+        auto entry = make_pair(o.createdAt, slot);
+        if (timeIndex.empty() || timeIndex.back() <= entry) {
+            timeIndex.push_back(entry);
+        } else {
+            timeIndex.insert(upper_bound(timeIndex.begin(), timeIndex.end(), entry), entry);
+        }
+    }
+
+    // The slot indexes are rebuilt whenever orders is reshaped, and the
+    // customer index with them, since archived orders leave it.
+    void rebuildOrderIndex() {
+        orderSlot.clear();
+        orderSlot.reserve(orders.size());
+        kitchenOpen.clear();
+        customers.clear();
+        for (size_t i = 0; i < orders.size(); ++i) {
+            const Order& o = orders[i];
+            orderSlot.emplace(o.id, i);
+            setKitchenState(orders[i], o.kitchen);
+            CustomerHistory& customer = customers[customerKey(o.customer)];
+            customer.name = o.customer;
+            customer.orderIds.push_back(o.id);
+            if (o.status == OrderStatus::Deleted) continue;
+            customer.orders++;
+            customer.spend += o.total;
+        }
+        rebuildTimeIndex();
+    }
+
+    static string customerKey(const string& name) {
+        string key(name);
+        for (char& c : key) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        return key;
+    }
+
+    void rebuildTimeIndex() {
+        timeIndex.resize(orders.size());
+        for (size_t i = 0; i < orders.size(); ++i) {
+            timeIndex[i] = make_pair(orders[i].createdAt, static_cast<uint32_t>(i));
+        }
+        sort(timeIndex.begin(), timeIndex.end());
+    }
+
+    void writeOrderHeader(TextBuffer& out) const {
+        out.str("ID").pad(6).str("Customer").pad(20).str("Item").pad(20)
+           .str("Qty").pad(8).str("Total").pad(10).str("Time").endLine();
+        out.repeat('-', 70).endLine();
+    }
+
+    // One row per line item with the line total; the ID, customer and time
+    // are only shown on a ticket's first row. Names come from the menu unless given,
+    // as for orders copied out of the store.
+    void writeOrderRows(TextBuffer& out, const Order& o, const vector<string>* names = nullptr) const {
+        static const string deleted = "[DELETED]";
+        size_t rows = o.status == OrderStatus::Deleted ? 1 : o.lines.size();
+        for (size_t i = 0; i < rows; ++i) {
+            bool hasLine = i < o.lines.size();
+            const string& item = names ? (*names)[i] : hasLine ? itemName(o.lines[i].itemId) : deleted;
+            Quantity quantity = hasLine ? o.lines[i].quantity : 0;
+            if (i == 0) out.num(o.id).pad(6).str(o.customer).pad(20);
+            else out.pad(6).pad(20);
+            out.str(item).pad(20).quantity(quantity).pad(8)
+               .money(hasLine ? lineAmount(quantity, o.lines[i].unitPrice) : 0).pad(10);
+            if (i == 0) out.time(o.createdAt);
+            out.endLine();
+        }
+    }
+
+    Order* findOrder(int id) {
+        auto it = orderSlot.find(id);
+        return it == orderSlot.end() ? nullptr : &orders[it->second];
+    }
+
+    const Order* findOrder(int id) const {
+        auto it = orderSlot.find(id);
+        return it == orderSlot.end() ? nullptr : &orders[it->second];
+    }
+
+    string storeFullMessage() const {
+        return "Order store is full (memory budget of " +
+               to_string(memoryBudget / (1024 * 1024)) + " MB reached).";
+    }
+
+    bool validQuantity(Category category, Quantity quantity, string& error) const {
+        if (category == Category::Drink) {
+            if (quantity >= 0 && quantity <= INT32_MAX) return true;
+            error = "Invalid liters.";
+            return false;
+        }
+        if (quantity < 0 || quantity % QUANTITY_ONE != 0) {
+            error = "Invalid quantity. Use digits only.";
+            return false;
+        }
+        if (quantity > 60 * QUANTITY_ONE) {
+            error = "Cannot order more than 60 food items. Please enter a smaller quantity.";
+            return false;
+        }
+        return true;
+    }
+
+    // Validates a new ticket of (menu ID, quantity) items and adds it to the
+    // live set; the caller holds the write lock and journals it.
+    bool admitOrder(const vector<pair<int, Quantity>>& items, const string& customer,
+                    Order& placed, string& error) {
+        if (orders.size() >= orderCapacity) {
+            error = storeFullMessage();
+            return false;
+        }
+        if (items.empty()) {
+            error = "Order has no items.";
+            return false;
+        }
+        if (items.size() > MAX_TICKET_LINES) {
+            error = "Too many items on one order (at most " + to_string(MAX_TICKET_LINES) + ").";
+            return false;
+        }
+        Order o;
+        o.menuVersion = menu->version;
+        o.lines.reserve(items.size());
+        for (const auto& entry : items) {
+            const MenuEntry* item = menu->find(entry.first);
+            if (!item) {
+                error = "Invalid selection.";
+                return false;
+            }
+            OrderLine line;
+            line.itemId = entry.first;
+            line.category = item->category;
+            line.quantity = entry.second;
+            line.unitPrice = item->price;
+            o.lines.push_back(line);
+        }
+        if (!isValidName(customer)) {
+            error = "Invalid name. Use letters and spaces only.";
+            return false;
+        }
+        for (const OrderLine& line : o.lines) {
+            if (!validQuantity(line.category, line.quantity, error)) return false;
+        }
+
+        o.id = nextId++;
+        o.status = OrderStatus::Active;
+        o.kitchen = KitchenState::Pending;
+        o.total = ticketTotal(o);
+        o.customer = customer;
+        o.createdAt = time(nullptr);
+
+        appendOrder(o);
+        recordSale(o, 1);
+        orderCount++;
+        queueKitchenEvent(o, KitchenEvent::New);
+        placed = o;
+        return true;
+    }
+
+    // Whole portions, returned in thousandths.
+    Quantity promptFoodQuantity(const string& prompt) const {
+        string qty;
+        while (true) {
+            cout << prompt;
+            if (!getline(cin, qty)) return 0;
+            bool valid = true;
+            for (char c : qty) {
+                if (!isdigit(c)) valid = false;
+            }
+            if (valid && !qty.empty() && qty.size() < 10) {
+                int quantity = stoi(qty);
+                // ADDED: Validate food quantity doesn't exceed 60
+                if (quantity > 60) {
+                    cout << "Cannot order more than 60 food items. Please enter a smaller quantity.\n";
+                    continue;
+                }
+                return quantity * QUANTITY_ONE;
+            }
+            cout << "Invalid quantity. Use digits only.\n";
+        }
+    }
+
+    // Liters with up to three decimals; re-prompts until the input parses.
+    Quantity promptLiters(const string& prompt) const {
+        string text;
+        while (true) {
+            cout << prompt;
+            if (!getline(cin, text)) return 0;
+            Quantity liters;
+            if (parseFixed(text, QUANTITY_DIGITS, liters) && liters >= 0) return liters;
+            cout << "Invalid liters.\n";
+        }
+    }
+
+    bool isValidName(const string& name) const {
+        for (char c : name) {
+            if (!isalpha(c) && c != ' ') return false;
+        }
+        return !name.empty();
+    }
+
+    // Item names go unescaped into menu.txt, orders.txt and journal
+    // records, all comma-separated.
+    static bool isValidItemName(const string& name) {
+        return !name.empty() && name.find_first_of(",;\r\n") == string::npos;
+    }
+
+    // Loads feedbacks.txt with the same chunked scan as loadCsv; lines
+    // without a numeric order ID are skipped. A torn last line (a crash
+    // mid-append) is left out and cut off the file, so the next append
+    // starts on a fresh line.
+    void loadFeedbacks() {
+        MappedFile file(feedbackFileName);
+        if (!file.begin()) return;
+        const char* end = file.end();
+        while (end > file.begin() && end[-1] != '\n') --end;
+        bool torn = end != file.end();
+        vector<TextRange> chunks = splitLines(file.begin(), end);
+        vector<vector<FeedbackRow>> scanned(chunks.size());
+        parseChunks(chunks, [&](size_t i, TextRange chunk) {
+            LineScanner lines(chunk);
+            TextRange text, field;
+            FeedbackRow row;
+            while (lines.next(text)) {
+                if (text.first == text.second) continue;
+                FieldScanner fields(text, ';');
+                if (!fields.next(field) || !parseInt(field, row.orderId)) continue;
+                if (!fields.next(row.timestamp)) continue;
+                if (!fields.rest(row.message)) row.message = TextRange(text.second, text.second);
+                scanned[i].push_back(row);
+            }
+        });
+        for (const vector<FeedbackRow>& chunk : scanned) {
+            for (const FeedbackRow& row : chunk) {
+                feedbacks.add(row.orderId, row.timestamp.first, rangeSize(row.timestamp),
+                              row.message.first, rangeSize(row.message));
+            }
+        }
+        if (torn && truncate(feedbackFileName.c_str(), end - file.begin()) != 0) {
+            cout << "Warning: could not drop the torn line at the end of " << feedbackFileName << ".\n";
+        }
+    }
+
+    // One feedbacks.txt line: "<order id>;<time>;<message>".
+    static string feedbackRecord(const Feedback& fb) {
+        return to_string(fb.orderId) + ';' + fb.timestamp + ';' + fb.message + '\n';
+    }
+
+    // After an append to feedbacks.txt failed: rewrites the file from the
+    // store and carries on appending to the new one. The caller holds
+    // feedbackMutex, so every appended record is in the store. If the new
+    // file cannot be reopened the log stays failed and the next feedback
+    // rewrites it again.
+    bool rewriteFeedbacks() {
+        AtomicFile file(feedbackFileName, &metrics);
+        for (size_t slot = 0; slot < feedbacks.size(); ++slot) {
+            file.stream() << feedbackRecord(feedbacks.feedback(slot));
+        }
+        if (!file.commit()) {
+            cout << "Warning: could not write " << feedbackFileName << ".\n";
+            return false;
+        }
+        int fd = open(feedbackFileName.c_str(), O_WRONLY | O_APPEND);
+        if (fd >= 0) {
+            feedbackLog.reset(fd);
+            if (feedbackFd >= 0) close(feedbackFd);
+            feedbackFd = fd;
+        }
+        return true;
+    }
+
+
+public:
+    OrderManager() : orderSlot(0, hash<int>(), equal_to<int>(), SlotIndex::allocator_type(&slotPool)),
+                     deferTimeIndex(false), nextId(1001), orderCount(0),
+                     memoryBudget(0), orderCapacity(0), kitchenOpen(less<int>(), TicketSet::allocator_type(&kitchenPool)),
+                     historyLoaded(false), salesVersion(0),
+                     liveColumnsVersion(0), journalFd(-1), feedbackFd(-1), journalRecords(0),
+                     csvStale(false), journal(metrics, journalFileName), feedbackLog(metrics, feedbackFileName),
+                     metricsInterval(DEFAULT_METRICS_INTERVAL), stopping(false) {
+        loadMenu();
+
+        bool migrate = loadFromFile();
+        journalFd = open(journalFileName.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        const char* window = getenv("ORDER_COMMIT_WINDOW_US");
+        chrono::microseconds commitWindow(window ? max(0, atoi(window)) : DEFAULT_COMMIT_WINDOW_US);
+        journal.start(journalFd, commitWindow);
+        if (migrate) compactJournal();
+        archiveClosedDays();
+        configureCapacity();
+        
+        loadFeedbacks();
+        feedbackFd = open(feedbackFileName.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        feedbackLog.start(feedbackFd, commitWindow);
+        if (!feedbacks.empty()) {
+            cout << "Feedback store: " << feedbacks.size() << " feedback(s), "
+                 << (feedbacks.bytesReserved() + 1023) / 1024 << " KB.\n";
+        }
+
+        loadPasswords();
+
+        const char* interval = getenv("ORDER_METRICS_INTERVAL");
+        if (interval) metricsInterval = max(0, atoi(interval));
+        if (metricsInterval > 0) metricsThread = thread(&OrderManager::metricsLoop, this);
+    }
+
+    ~OrderManager() {
+        if (journalRecords > 0) compactJournal();
+        journal.stop();
+        if (journalFd >= 0) close(journalFd);
+        feedbackLog.stop();
+        if (feedbackFd >= 0) close(feedbackFd);
+        if (csvStale) exportCsv(fileName);
+
+        if (metricsThread.joinable()) {
+            {
+                lock_guard<mutex> guard(metricsWakeMutex);
+                stopping = true;
+            }
+            metricsWake.notify_one();
+            metricsThread.join();
+            writeMetrics();
+        }
+    }
+
+    // Writes metrics.prom (Prometheus text format) through a temporary file
+    // and a rename, so a scraper never reads a half-written file.
+    bool writeMetrics() const {
+        AtomicFile file(metricsFile);
+        {
+            TextBuffer out(file.stream());
+            metrics.writePrometheus(out);
+            size_t live, open, feedbackCount;
+            {
+                ReadGuard guard(storeLock);
+                live = static_cast<size_t>(orderCount);
+                open = kitchenOpen.size();
+            }
+            {
+                lock_guard<mutex> guard(feedbackMutex);
+                feedbackCount = feedbacks.size();
+            }
+            out.str("# HELP order_live_orders Orders in the live set that are not deleted.").endLine();
+            out.str("# TYPE order_live_orders gauge").endLine();
+            out.str("order_live_orders ").num(static_cast<int64_t>(live)).endLine();
+            out.str("# HELP order_kitchen_open Pending and cooking tickets.").endLine();
+            out.str("# TYPE order_kitchen_open gauge").endLine();
+            out.str("order_kitchen_open ").num(static_cast<int64_t>(open)).endLine();
+            out.str("# HELP order_feedbacks Stored customer feedbacks.").endLine();
+            out.str("# TYPE order_feedbacks gauge").endLine();
+            out.str("order_feedbacks ").num(static_cast<int64_t>(feedbackCount)).endLine();
         }
+        return file.commit(false);
+    }
 
-        ifstream chefFin(chefPasswordFile);
-        if (chefFin) {
-            getline(chefFin, chefPassword);
-        } else {
-            chefPassword = "123";
-            saveChefPassword();
+    // Cashier view of the operation timings; also refreshes metrics.prom.
+    void showMetrics() const {
+        {
+            TextBuffer out(cout);
+            out.str("\n====== Performance Metrics ======").endLine();
+            metrics.writeTable(out);
         }
+        if (writeMetrics()) cout << "Written to " << metricsFile << ".\n";
     }
 
-    void savePassword() const {
-        ofstream fout(passwordFile);
-        fout << cashierPassword;
+    // Thread-safe order operations shared by the interactive menus and the
+    // socket server. They validate, mutate and persist under the store lock
+    // and never read from cin.
+    bool placeOrder(const vector<pair<int, Quantity>>& items, const string& customer,
+                    Order& placed, string& error) {
+        OpTimer timer(metrics, Metric::PlaceOrder);
+        CommitWait commit(journal);
+        {
+            WriteGuard guard(storeLock);
+            if (currentTime().compare(0, 10, liveDay) != 0) {
+                archiveClosedDays();
+            }
+            if (!admitOrder(items, customer, placed, error)) return false;
+            commit.seq = appendJournal('C', placed);
+        }
+        if (awaitCommit(commit, error)) return true;
+        error = "Order " + to_string(placed.id) + ": " + error;
+        return false;
     }
 
-    void saveChefPassword() const {
-        ofstream fout(chefPasswordFile);
-        fout << chefPassword;
+    // Bulk variant of placeOrder: every request is validated with the same
+    // rules, and the accepted ones are committed under one lock hold with a
+    // single journal write. Returns the number accepted; rejected requests
+    // are reported as (line, error). If the accepted orders could not be
+    // saved, unsaved (when given) says which; they stay placed all the same.
+    size_t placeOrders(const vector<OrderRequest>& batch, vector<pair<int, string>>& rejected,
+                       string* unsaved = nullptr) {
+        OpTimer timer(metrics, Metric::PlaceBatch);
+        CommitWait commit(journal);
+        vector<int> acceptedLines;
+        int firstId = 0, lastId = 0;
+        {
+            WriteGuard guard(storeLock);
+            if (currentTime().compare(0, 10, liveDay) != 0) {
+                archiveClosedDays();
+            }
+            string records;
+            for (const OrderRequest& req : batch) {
+                Order o;
+                string error;
+                if (!admitOrder(req.items, req.customer, o, error)) {
+                    rejected.push_back(make_pair(req.line, error));
+                    continue;
+                }
+                records += journalRecord('C', o);
+                acceptedLines.push_back(req.line);
+                if (!firstId) firstId = o.id;
+                lastId = o.id;
+            }
+            if (!acceptedLines.empty()) commit.seq = writeJournal(records, static_cast<int>(acceptedLines.size()));
+        }
+        string error;
+        if (!awaitCommit(commit, error) && unsaved) {
+            *unsaved = "Orders " + to_string(firstId) + " to " + to_string(lastId) + ": " + error;
+        }
+        return acceptedLines.size();
     }
 
-    void loadMenu() {
-        ifstream min(menuFile);
-        if (min) {
-            string line;
-            while (getline(min, line)) {
-                if (line.empty()) continue;
-                stringstream ss(line);
-                string idStr, name, category, priceStr;
-                getline(ss, idStr, ',');
-                getline(ss, name, ',');
-                getline(ss, category, ',');
-                getline(ss, priceStr);
-                int id = stoi(idStr);
-                double price = stod(priceStr);
-                menu[id] = {name, {category, price}};
+    // Orders placed in [from, to], oldest first, with their item names.
+    // Archived days are read only when the range reaches them, one day file
+    // each; live orders come from a binary search into the time index.
+    vector<pair<Order, vector<string>>> ordersBetween(int64_t from, int64_t to) const {
+        ReadGuard guard(storeLock);
+        vector<pair<Order, vector<string>>> found;
+        string firstDay = dayOf(from), lastDay = dayOf(to);
+        for (const auto& entry : archivedDays) {
+            if (entry.first < firstDay || entry.first > lastDay || entry.first >= liveDay) continue;
+            vector<pair<Order, vector<string>>> day;
+            readDayFile(entry.first, day);
+            for (auto& item : day) {
+                if (item.first.createdAt >= from && item.first.createdAt <= to) found.push_back(std::move(item));
             }
-        } else {
-            menu[1] = {"TIBS", {"food", 500.0}};
-            menu[2] = {"KITFO", {"food", 600.0}};
-            menu[3] = {"DORO WOTIE", {"food", 1050.0}};
-            menu[4] = {"MINERAL WATER", {"drink", 30.0}};
-            menu[5] = {"BEER", {"drink", 120.0}};
-            saveMenu();
         }
+        auto it = lower_bound(timeIndex.begin(), timeIndex.end(), make_pair(from, uint32_t(0)));
+        for (; it != timeIndex.end() && it->first <= to; ++it) {
+            const Order& o = orders[it->second];
+            found.push_back(make_pair(o, itemNames(o)));
+        }
+        return found;
     }
 
-    void saveMenu() const {
-        ofstream mout(menuFile);
-        for (const auto& item : menu) {
-            mout << item.first << ',' << item.second.first << ',' 
-                 << item.second.second.first << ',' << fixed << setprecision(2) 
-                 << item.second.second.second << '\n';
+    // Customers whose name starts with prefix, ignoring case, in name order
+    // and at most limit of them: one range scan of the customer index.
+    vector<CustomerHistory> customersByPrefix(const string& prefix, size_t limit) const {
+        OpTimer timer(metrics, Metric::CustomerLookup);
+        ReadGuard guard(storeLock);
+        vector<CustomerHistory> found;
+        string key = customerKey(prefix);
+        for (auto it = customers.lower_bound(key);
+             it != customers.end() && found.size() < limit && it->first.compare(0, key.size(), key) == 0; ++it) {
+            found.push_back(it->second);
         }
+        return found;
     }
 
-    void loadFromFile() {
-        ifstream fin(fileName);
-        if (!fin) return;
-        string line;
-        getline(fin, line);
-        int maxId = 1000;
-        OrderNode* last = nullptr;
-        
-        while (getline(fin, line)) {
-            if (line.empty()) continue;
-            stringstream ss(line);
-            Order o;
-            getline(ss, line, ','); o.id = stoi(line);
-            getline(ss, o.customer, ',');
-            getline(ss, o.item, ',');
-            getline(ss, o.category, ',');
-            getline(ss, line, ','); o.quantity = stod(line);
-            getline(ss, line, ','); o.total = stod(line);
-            getline(ss, o.timestamp);
-            
-            OrderNode* newNode = new OrderNode{o, nullptr};
-            if (!ordersHead) {
-                ordersHead = newNode;
-                last = newNode;
-            } else {
-                last->next = newNode;
-                last = newNode;
+    // Every live order of one customer (name compared ignoring case), oldest
+    // first, with its item names.
+    bool customerOrders(const string& name, CustomerHistory& customer,
+                        vector<pair<Order, vector<string>>>& history) const {
+        OpTimer timer(metrics, Metric::CustomerLookup);
+        ReadGuard guard(storeLock);
+        auto it = customers.find(customerKey(name));
+        if (it == customers.end()) return false;
+        customer = it->second;
+        history.clear();
+        history.reserve(customer.orderIds.size());
+        for (int id : customer.orderIds) {
+            const Order* o = findOrder(id);
+            if (o) history.push_back(make_pair(*o, itemNames(*o)));
+        }
+        return true;
+    }
+
+    bool lookupOrder(int id, Order& found, vector<string>& items) const {
+        OpTimer timer(metrics, Metric::LookupOrder);
+        ReadGuard guard(storeLock);
+        const Order* o = findOrder(id);
+        if (!o) return false;
+        found = *o;
+        items = itemNames(*o);
+        return true;
+    }
+
+    // Finds a ticket of a closed day by reading only the day file whose ID
+    // range holds it. Archived tickets are read-only.
+    bool lookupArchivedOrder(int id, Order& found, vector<string>& items) const {
+        ReadGuard guard(storeLock);
+        string day = archivedDayOf(id);
+        if (day.empty() || findOrder(id)) return false;
+        vector<pair<Order, vector<string>>> dayOrders;
+        readDayFile(day, dayOrders);
+        for (auto& item : dayOrders) {
+            if (item.first.id != id) continue;
+            found = std::move(item.first);
+            items = std::move(item.second);
+            return true;
+        }
+        return false;
+    }
+
+    // Sets the quantity of one line item (0-based) and retotals the ticket
+    // at the unit price captured from menu version o->menuVersion when it was
+    // placed, so a later price change does not reprice it.
+    bool changeQuantity(int id, size_t line, Quantity quantity, Order& updated, Money& diff,
+                        string& error) {
+        OpTimer timer(metrics, Metric::ChangeQuantity);
+        CommitWait commit(journal);
+        {
+            WriteGuard guard(storeLock);
+            Order* o = findOrder(id);
+            if (!o) {
+                error = "Order ID not found.";
+                return false;
             }
-            maxId = max(maxId, o.id);
-            orderCount++;
+            if (o->status == OrderStatus::Deleted) {
+                error = "Order " + to_string(id) + " is deleted.";
+                return false;
+            }
+            if (line >= o->lines.size()) {
+                error = "Order " + to_string(id) + " has no item " + to_string(line + 1) + ".";
+                return false;
+            }
+            if (!validQuantity(o->lines[line].category, quantity, error)) return false;
+
+            Order before = *o;
+            o->lines[line].quantity = quantity;
+            o->total = ticketTotal(*o);
+            diff = o->total - before.total;
+            recordSale(before, -1);
+            recordSale(*o, 1);
+            commit.seq = appendJournal('U', *o);
+            if (o->kitchen != KitchenState::Ready) queueKitchenEvent(*o, KitchenEvent::Changed);
+            updated = *o;
         }
-        nextId = maxId + 1;
+        return awaitCommit(commit, error);
     }
 
-    void saveToFile() const {
-        ofstream fout(fileName);
-        fout << "ID,Customer,Item,Category,Quantity,Total,Time\n";
-        OrderNode* current = ordersHead;
-        while (current) {
-            const Order& o = current->order;
-            fout << o.id << "," << o.customer << "," << o.item << ","
-                 << o.category << "," << fixed << setprecision(2) << o.quantity << ","
-                 << o.total << "," << o.timestamp << "\n";
-            current = current->next;
+    bool cancelOrder(int id, string& error) {
+        OpTimer timer(metrics, Metric::CancelOrder);
+        CommitWait commit(journal);
+        {
+            WriteGuard guard(storeLock);
+            Order* o = findOrder(id);
+            if (!o) {
+                error = "Order ID not found.";
+                return false;
+            }
+            if (o->status == OrderStatus::Deleted) {
+                error = "Order " + to_string(id) + " is already deleted.";
+                return false;
+            }
+            bool inKitchen = kitchenOpen.count(id) > 0;
+            recordSale(*o, -1);
+            markDeleted(*o);
+            commit.seq = appendJournal('D', *o);
+            if (inKitchen) queueKitchenEvent(*o, KitchenEvent::Cancelled);
+            orderCount--;
         }
+        return awaitCommit(commit, error);
     }
 
-    bool isValidName(const string& name) const {
-        for (char c : name) {
-            if (!isalpha(c) && c != ' ') return false;
+    // Moves a ticket forward through pending -> cooking -> ready.
+    bool advanceKitchen(int id, KitchenState state, string& error) {
+        OpTimer timer(metrics, Metric::AdvanceKitchen);
+        CommitWait commit(journal);
+        {
+            WriteGuard guard(storeLock);
+            Order* o = findOrder(id);
+            if (!o || o->status == OrderStatus::Deleted) {
+                error = "Order ID not found.";
+                return false;
+            }
+            if (state <= o->kitchen) {
+                error = "Order " + to_string(id) + " is already " + kitchenStateName(o->kitchen) + ".";
+                return false;
+            }
+            setKitchenState(*o, state);
+            commit.seq = writeJournal("K," + to_string(id) + "," + to_string(static_cast<int>(state)) + "\n", 1);
         }
-        return !name.empty();
+        return awaitCommit(commit, error);
     }
 
-    void loadFeedbacks() {
-        ifstream fin(feedbackFileName);
-        if (!fin) return;
-        string line;
-        FeedbackNode* last = nullptr;
-        
-        while (getline(fin, line)) {
-            if (line.empty()) continue;
-            stringstream ss(line);
-            Feedback fb;
-            getline(ss, line, ';'); fb.orderId = stoi(line);
-            getline(ss, fb.timestamp, ';');
-            getline(ss, fb.message);
-            
-            FeedbackNode* newNode = new FeedbackNode{fb, nullptr};
-            if (!feedbacksHead) {
-                feedbacksHead = newNode;
-                last = newNode;
-            } else {
-                last->next = newNode;
-                last = newNode;
+    // Pending and cooking tickets, oldest first, rendered for the kitchen.
+    vector<pair<int, string>> openTickets() const {
+        ReadGuard guard(storeLock);
+        vector<pair<int, string>> tickets;
+        tickets.reserve(kitchenOpen.size());
+        for (int id : kitchenOpen) {
+            const Order* o = findOrder(id);
+            if (o) tickets.push_back(make_pair(id, renderKitchenTicket(*o)));
+        }
+        return tickets;
+    }
+
+    KitchenFeed& kitchen() { return kitchenFeed; }
+
+    bool addFeedback(int orderId, const string& message, string& error) {
+        OpTimer timer(metrics, Metric::AddFeedback);
+        {
+            ReadGuard guard(storeLock);
+            const Order* o = findOrder(orderId);
+            if (!o || o->status == OrderStatus::Deleted) {
+                error = "Order ID not found or invalid.";
+                return false;
             }
         }
+        if (message.empty()) {
+            error = "Feedback cannot be empty.";
+            return false;
+        }
+        Feedback fb;
+        fb.orderId = orderId;
+        fb.message = message;
+        fb.timestamp = currentTime();
+
+        CommitWait commit(feedbackLog);
+        {
+            lock_guard<mutex> guard(feedbackMutex);
+            feedbacks.add(fb);
+            commit.seq = feedbackLog.append(feedbackRecord(fb));
+        }
+        uint64_t seq = commit.seq;
+        if (commit.wait(error)) return true;
+        lock_guard<mutex> guard(feedbackMutex);
+        if (!feedbackLog.isDurable(seq) && !rewriteFeedbacks()) return false;
+        error.clear();
+        return true;
     }
 
-    void saveFeedback(const Feedback& fb) const {
-        ofstream fout(feedbackFileName, ios::app);
-        fout << fb.orderId << ';' << fb.timestamp << ';' << fb.message << '\n';
+    vector<Feedback> feedbackFor(int orderId) const {
+        lock_guard<mutex> guard(feedbackMutex);
+        vector<Feedback> found;
+        for (uint32_t slot : feedbacks.forOrder(orderId)) found.push_back(feedbacks.feedback(slot));
+        return found;
     }
 
-    OrderNode* mergeSort(OrderNode* head, bool (*cmp)(const Order&, const Order&)) {
-        if (!head || !head->next) return head;
-        
-        OrderNode* slow = head;
-        OrderNode* fast = head->next;
-        while (fast && fast->next) {
-            slow = slow->next;
-            fast = fast->next->next;
-        }
-        OrderNode* mid = slow->next;
-        slow->next = nullptr;
-        
-        OrderNode* left = mergeSort(head, cmp);
-        OrderNode* right = mergeSort(mid, cmp);
-        
-        OrderNode dummy;
-        OrderNode* tail = &dummy;
-        
-        while (left && right) {
-            if (cmp(left->order, right->order)) {
-                tail->next = left;
-                left = left->next;
-            } else {
-                tail->next = right;
-                right = right->next;
+    // Feedback mentioning every word of query (case-insensitive), oldest first.
+    vector<Feedback> searchFeedback(const string& query) const {
+        OpTimer timer(metrics, Metric::SearchFeedback);
+        lock_guard<mutex> guard(feedbackMutex);
+        vector<uint32_t> slots = feedbacks.search(query);
+        vector<Feedback> found;
+        found.reserve(slots.size());
+        for (uint32_t slot : slots) found.push_back(feedbacks.feedback(slot));
+        return found;
+    }
+
+    // Sales in [from, to) over the archived days and the live set, with the
+    // topK items by revenue. Archived days are loaded into columns once and
+    // the live columns are rebuilt only after a sale changed, so repeated
+    // reports cost one scan.
+    SalesReport salesBetween(int64_t from, int64_t to, size_t topK) {
+        OpTimer timer(metrics, Metric::SalesReport);
+        if (!historyLoaded) {
+            WriteGuard guard(storeLock);
+            lock_guard<mutex> columnsGuard(analyticsMutex);
+            if (!historyLoaded) loadSalesHistory();
+        }
+        ReadGuard guard(storeLock);
+        lock_guard<mutex> columnsGuard(analyticsMutex);
+        if (liveColumnsVersion != salesVersion) {
+            salesLive.clear();
+            salesLive.reserve(orders.size());
+            for (const auto& entry : timeIndex) appendSalesRows(salesLive, orders[entry.second]);
+            liveColumnsVersion = salesVersion;
+        }
+
+        SalesReport report;
+        report.totals.itemRevenue.assign(salesItemByCode.size(), 0);
+        report.totals.itemQuantity.assign(salesItemByCode.size(), 0);
+        for (const SalesColumns* columns : {&salesHistory, &salesLive}) {
+            pair<size_t, size_t> range = salesRange(*columns, from, to);
+            scanSales(*columns, range.first, range.second, report.totals);
+            report.rowsScanned += range.second - range.first;
+        }
+
+        vector<uint16_t> codes;
+        for (size_t code = 0; code < salesItemByCode.size(); ++code) {
+            if (report.totals.itemQuantity[code] != 0 || report.totals.itemRevenue[code] != 0) {
+                codes.push_back(static_cast<uint16_t>(code));
             }
-            tail = tail->next;
         }
-        
-        tail->next = (left) ? left : right;
-        return dummy.next;
+        size_t k = min(topK, codes.size());
+        const vector<Money>& revenue = report.totals.itemRevenue;
+        partial_sort(codes.begin(), codes.begin() + k, codes.end(),
+                     [&](uint16_t a, uint16_t b) { return revenue[a] > revenue[b]; });
+        for (size_t i = 0; i < k; ++i) {
+            int itemId = salesItemByCode[codes[i]];
+            Category category = Category::Other;
+            const MenuEntry* item = menu->find(itemId);
+            if (item) {
+                category = item->category;
+            } else if (retiredItems.count(itemId)) {
+                category = retiredItems.at(itemId).second;
+            }
+            report.topItems.push_back({itemName(itemId), category,
+                                       report.totals.itemQuantity[codes[i]], revenue[codes[i]]});
+        }
+        return report;
     }
 
-    static bool compareByTime(const Order& a, const Order& b) {
-        return a.timestamp < b.timestamp;
+    // Folds the journal into a fresh snapshot now instead of waiting for
+    // the compaction threshold.
+    void checkpoint() {
+        WriteGuard guard(storeLock);
+        compactJournal();
     }
 
-public:
-    OrderManager() : nextId(1001), ordersHead(nullptr), feedbacksHead(nullptr), orderCount(0) {
-        loadMenu();
+    // Re-estimates the live-order capacity after a bulk load.
+    void refreshCapacity() {
+        WriteGuard guard(storeLock);
+        updateCapacity();
+    }
 
-        ofstream create(fileName, ios::app);
-        create.close();
-        loadFromFile();
-        
-        ifstream fbCreate(feedbackFileName, ios::app);
-        fbCreate.close();
-        loadFeedbacks();
+    // Points the journal's (or the feedback log's) descriptor at /dev/full
+    // so its next write fails; for --fault-test.
+    bool breakLog(bool feedback) {
+        int full = open("/dev/full", O_WRONLY);
+        if (full < 0) return false;
+        bool broken = dup2(full, feedback ? feedbackFd : journalFd) >= 0;
+        close(full);
+        return broken;
+    }
 
-        loadPasswords();
+    bool storeFull(string& error) const {
+        ReadGuard guard(storeLock);
+        if (orders.size() < orderCapacity) return false;
+        error = storeFullMessage();
+        return true;
     }
 
-    ~OrderManager() {
-        OrderNode* currOrder = ordersHead;
-        while (currOrder) {
-            OrderNode* temp = currOrder;
-            currOrder = currOrder->next;
-            delete temp;
-        }
-        
-        FeedbackNode* currFeedback = feedbacksHead;
-        while (currFeedback) {
-            FeedbackNode* temp = currFeedback;
-            currFeedback = currFeedback->next;
-            delete temp;
+    bool menuItem(int menuId, string& name, Category& category, Money& price) const {
+        MenuRef snapshot = currentMenu();
+        const MenuEntry* item = snapshot->find(menuId);
+        if (!item) return false;
+        name = item->name;
+        category = item->category;
+        price = item->price;
+        return true;
+    }
+
+    void todaySales(string& day, int& totalOrders, Money& totalRevenue) const {
+        day = currentTime().substr(0, 10);
+        ReadGuard guard(storeLock);
+        auto it = dailySales.find(day);
+        totalOrders = it == dailySales.end() ? 0 : it->second.orders;
+        totalRevenue = it == dailySales.end() ? 0 : it->second.revenue;
+    }
+
+    bool popularFood(string& item, Quantity& units) const {
+        ReadGuard guard(storeLock);
+        if (foodRanking.empty()) return false;
+        item = itemName(foodRanking.begin()->second);
+        units = -foodRanking.begin()->first;
+        return true;
+    }
+
+    // CSV <-> binary converters for the command line. Importing replaces the
+    // live order set with the CSV contents and rewrites orders.bin.
+    bool exportOrders(const string& path) {
+        WriteGuard guard(storeLock);
+        if (!exportCsv(path)) return false;
+        if (path == fileName) csvStale = false;
+        cout << "Exported " << orders.size() << " order(s) to " << path << ".\n";
+        return true;
+    }
+
+    bool importOrders(const string& path) {
+        if (!ifstream(path)) {
+            cout << "Cannot open " << path << ".\n";
+            return false;
         }
+        WriteGuard guard(storeLock);
+        orders.clear();
+        orderSlot.clear();
+        timeIndex.clear();
+        kitchenOpen.clear();
+        customers.clear();
+        dailySales.clear();
+        foodUnits.clear();
+        foodRanking.clear();
+        orderCount = 0;
+        int maxId = 1000;
+        deferTimeIndex = true;
+        loadCsv(path, maxId);
+        deferTimeIndex = false;
+        rebuildTimeIndex();
+        nextId = max(nextId, maxId + 1);
+        loadArchivedSales();
+        compactJournal();
+        updateCapacity();
+        csvStale = (path != fileName);
+        cout << "Imported " << orders.size() << " order(s) from " << path
+             << " into " << snapshotFileName << ".\n";
+        return true;
     }
 
     void changePassword(bool isCashier = true) {
@@ -308,7 +3909,7 @@ public:
             cout << "Enter current password: ";
             string oldPass = getPassword();
             
-            if (oldPass != cashierPassword) {
+            if (!verifyPassword(oldPass)) {
                 cout << "\nIncorrect current password.\n";
                 return;
             }
@@ -321,6 +3922,7 @@ public:
                 return;
             }
             
+            lock_guard<mutex> guard(authMutex);
             cashierPassword = newPass;
             savePassword();
             cout << "\nCashier password changed successfully.\n";
@@ -328,7 +3930,7 @@ public:
             cout << "Enter current chef password: ";
             string oldPass = getPassword();
             
-            if (oldPass != chefPassword) {
+            if (!verifyPassword(oldPass, false)) {
                 cout << "\nIncorrect current password.\n";
                 return;
             }
@@ -341,6 +3943,7 @@ public:
                 return;
             }
             
+            lock_guard<mutex> guard(authMutex);
             chefPassword = newPass;
             saveChefPassword();
             cout << "\nChef password changed successfully.\n";
@@ -348,26 +3951,25 @@ public:
     }
 
     bool verifyPassword(const string& input, bool isCashier = true) const {
+        lock_guard<mutex> guard(authMutex);
         return isCashier ? (input == cashierPassword) : (input == chefPassword);
     }
 
+    string menuListing() const {
+        return currentMenu()->listing;
+    }
+
     void displayMenu() const {
-        cout << "\n----- FOOD MENU -----\n";
-        for (const auto& kv : menu) {
-            if (kv.second.second.first == "food") {
-                cout << kv.first << ". " << left << setw(20) << kv.second.first
-                     << ": " << fixed << setprecision(2) << kv.second.second.second << " birr" << endl;
-            }
-        }
-        
-        cout << "\n----- DRINK MENU -----\n";
-        for (const auto& kv : menu) {
-            if (kv.second.second.first == "drink") {
-                cout << kv.first << ". " << left << setw(20) << kv.second.first
-                     << ": " << fixed << setprecision(2) << kv.second.second.second << " birr" << endl;
-            }
-        }
-        cout << "------------------------\n";
+        cout << currentMenu()->listing << flush;
+    }
+
+    bool promptPrice(const string& prompt, Money& price) const {
+        string text;
+        cout << prompt;
+        getline(cin, text);
+        if (parseFixed(text, MONEY_DIGITS, price) && price >= 0) return true;
+        cout << "Invalid price.\n";
+        return false;
     }
 
     void updateMenu() {
@@ -381,7 +3983,10 @@ public:
             cout << "Enter item ID to update: ";
             cin >> id;
             cin.ignore();
-            if (!menu.count(id)) {
+            string currentName;
+            Category currentCategory;
+            Money currentPrice;
+            if (!menuItem(id, currentName, currentCategory, currentPrice)) {
                 cout << "Item ID not found.\n";
                 return;
             }
@@ -389,155 +3994,159 @@ public:
             int changeOption;
             cin >> changeOption;
             cin.ignore();
+            if (changeOption < 1 || changeOption > 3) {
+                cout << "Invalid option.\n";
+                return;
+            }
 
-            if (changeOption == 1) {
-                string newName;
+            string newName;
+            Money newPrice = currentPrice;
+            if (changeOption == 1 || changeOption == 3) {
                 cout << "Enter new name: ";
                 getline(cin, newName);
-                menu[id].first = newName;
-                cout << "Item name updated.\n";
-            } else if (changeOption == 2) {
-                double newPrice;
-                cout << "Enter new price: ";
-                cin >> newPrice;
-                cin.ignore();
-                menu[id].second.second = newPrice;
-                cout << "Item price updated.\n";
-            } else if (changeOption == 3) {
-                string newName;
-                double newPrice;
-                cout << "Enter new name: ";
-                getline(cin, newName);
-                cout << "Enter new price: ";
-                cin >> newPrice;
-                cin.ignore();
-                menu[id] = {newName, {menu[id].second.first, newPrice}};
-                cout << "Item name and price updated.\n";
-            } else {
-                cout << "Invalid option.\n";
+                if (!isValidItemName(newName)) {
+                    cout << "Invalid name. Commas and semicolons are not allowed.\n";
+                    return;
+                }
+            }
+            if (changeOption == 2 || changeOption == 3) {
+                if (!promptPrice("Enter new price: ", newPrice)) return;
             }
+            lock_guard<mutex> edit(menuEditMutex);
+            shared_ptr<MenuSnapshot> next = make_shared<MenuSnapshot>(*menu);
+            auto item = next->items.find(id);
+            if (item == next->items.end()) {
+                cout << "Item ID not found.\n";
+                return;
+            }
+            if (changeOption != 2) item->second.first = newName;
+            if (changeOption != 1) item->second.second.second = newPrice;
+            publishMenu(next);
+            cout << (changeOption == 1 ? "Item name updated.\n" : changeOption == 2 ? "Item price updated.\n"
+                                                                      : "Item name and price updated.\n");
         } else if (option == 2) {
-            int newId = menu.rbegin()->first + 1;
             string name, category;
-            double price;
+            Money price;
             
             cout << "Enter item name: ";
             getline(cin, name);
+            if (!isValidItemName(name)) {
+                cout << "Invalid name. Commas and semicolons are not allowed.\n";
+                return;
+            }
             
             cout << "Enter category (food/drink): ";
             getline(cin, category);
             
-            cout << "Enter price: ";
-            cin >> price;
-            cin.ignore();
+            if (!promptPrice("Enter price: ", price)) return;
             
-            menu[newId] = {name, {category, price}};
+            lock_guard<mutex> edit(menuEditMutex);
+            shared_ptr<MenuSnapshot> next = make_shared<MenuSnapshot>(*menu);
+            int newId = next->items.empty() ? 1 : next->items.rbegin()->first + 1;
+            if (newId > MAX_MENU_ID) {
+                cout << "Menu is full.\n";
+                return;
+            }
+            next->items[newId] = {name, {category, price}};
+            publishMenu(next);
             cout << "New menu item added.\n";
         } else {
             cout << "Invalid option.\n";
         }
-        saveMenu();
     }
     
     void createOrder() {
-        if (orderCount >= MAX_ORDERS) {
-            cout << "Maximum order limit (60) reached!\n";
+        string error;
+        if (storeFull(error)) {
+            cout << error << "\n";
             return;
         }
         
         displayMenu();
         cout << "0. Cancel" << endl;
-        int choice;
-        cout << "Enter menu number: ";
-        cin >> choice;
-        cin.ignore();
-        if (choice == 0) return;
-        if (!menu.count(choice)) {
-            cout << "Invalid selection.\n";
-            return;
+        vector<pair<int, Quantity>> items;
+        while (items.size() < MAX_TICKET_LINES) {
+            int choice;
+            cout << (items.empty() ? "Enter menu number: " : "Enter next menu number (0 to finish): ");
+            cin >> choice;
+            cin.ignore();
+            if (choice == 0) break;
+            string itemName;
+            Category category;
+            Money price;
+            if (!menuItem(choice, itemName, category, price)) {
+                cout << "Invalid selection.\n";
+                continue;
+            }
+
+            Quantity quantity = category == Category::Drink ? promptLiters("Enter liters: ")
+                                                            : promptFoodQuantity("Enter quantity: ");
+            items.push_back(make_pair(choice, quantity));
         }
+        if (items.empty()) return;
 
-        Order o;
-        o.id = nextId++;
+        string customer;
         while (true) {
             cout << "Enter customer name: ";
-            getline(cin, o.customer);
-            if (isValidName(o.customer)) break;
+            if (!getline(cin, customer)) return;
+            if (isValidName(customer)) break;
             cout << "Invalid name. Use letters and spaces only.\n";
         }
 
-        o.category = menu.at(choice).second.first;
-        o.item = menu.at(choice).first;
-        
-        if (o.category == "drink") {
-            cout << "Enter liters: ";
-            cin >> o.quantity;
-            cin.ignore();
-        } else {
-            string qty;
-            while (true) {
-                cout << "Enter quantity: ";
-                getline(cin, qty);
-                bool valid = true;
-                for (char c : qty) {
-                    if (!isdigit(c)) valid = false;
-                }
-                if (valid && !qty.empty()) {
-                    int quantity = stoi(qty);
-                    // ADDED: Validate food quantity doesn't exceed 60
-                    if (quantity > 60) {
-                        cout << "Cannot order more than 60 food items. Please enter a smaller quantity.\n";
-                        continue;
+        Order o;
+        if (!placeOrder(items, customer, o, error)) {
+            cout << error << "\n";
+            return;
+        }
+        cout << "Order ID " << o.id << " created at " << formatTime(o.createdAt) << " with "
+             << o.lines.size() << " item(s). Total: " << formatMoney(o.total) << " birr.\n";
+    }
+
+    // Streams the order table a page of tickets at a time, in insertion
+    // order or (sorted) time order. Each page is rendered under the read
+    // lock and written in one go; the lock is released between pages, so
+    // tills are not held up while the user reads. page 0 lists everything,
+    // asking before each further page when prompt is set; page N >= 1
+    // shows only that page.
+    void listOrderPages(bool sorted, size_t page, size_t limit, bool prompt) const {
+        TextBuffer out(cout);
+        size_t first = page > 0 ? (page - 1) * limit : 0;
+        size_t pos = first;
+        size_t total = 0;
+        while (true) {
+            {
+                OpTimer timer(metrics, Metric::ListOrders);
+                ReadGuard guard(storeLock);
+                total = orders.size();
+                if (pos == first) {
+                    if (total == 0) {
+                        out.str("\nNo orders to display.").endLine();
+                        return;
                     }
-                    o.quantity = quantity;
-                    break;
+                    if (first >= total) {
+                        out.str("No orders on page ").num(static_cast<int64_t>(page)).str(".").endLine();
+                        return;
+                    }
+                    out.str("\n------ Order List ------").endLine();
+                    writeOrderHeader(out);
+                }
+                size_t end = min(total, pos + limit);
+                for (; pos < end; ++pos) {
+                    writeOrderRows(out, sorted ? orders[timeIndex[pos].second] : orders[pos]);
                 }
-                cout << "Invalid quantity. Use digits only.\n";
             }
-        }
-
-        o.total = menu.at(choice).second.second * o.quantity;
-        o.timestamp = currentTime();
-
-        OrderNode* newNode = new OrderNode{o, nullptr};
-        if (!ordersHead) {
-            ordersHead = newNode;
-        } else {
-            OrderNode* current = ordersHead;
-            while (current->next) {
-                current = current->next;
+            if (page > 0) {
+                out.str("Page ").num(static_cast<int64_t>(page)).str(" of ")
+                   .num(static_cast<int64_t>((total + limit - 1) / limit)).str(".").endLine();
             }
-            current->next = newNode;
+            out.flush();
+            if (page > 0 || pos >= total) return;
+            if (prompt && !continuePaging(pos, total, "orders")) return;
         }
-        
-        orderCount++;
-        saveToFile();
-        cout << "Order ID " << o.id << " created at " << o.timestamp << ". Total: "
-             << fixed << setprecision(2) << o.total << " birr.\n";
     }
 
     void listOrders() const {
-        if (!ordersHead) {
-            cout << "\nNo orders to display.\n";
-            return;
-        }
-        cout << "\n------ Order List ------\n";
-        cout << left << setw(6) << "ID" << setw(20) << "Customer"
-             << setw(20) << "Item" << setw(8) << "Qty"
-             << setw(10) << "Total" << "Time" << endl;
-        cout << string(70, '-') << endl;
-        
-        OrderNode* current = ordersHead;
-        while (current) {
-            const Order& o = current->order;
-            cout << left << setw(6) << o.id
-                 << setw(20) << o.customer
-                 << setw(20) << o.item
-                 << setw(8) << fixed << setprecision(2) << o.quantity
-                 << setw(10) << o.total
-                 << o.timestamp << endl;
-            current = current->next;
-        }
+        listOrderPages(false, 0, LIST_PAGE_ROWS, consoleInput());
     }
 
     void updateOrderById() {
@@ -546,58 +4155,48 @@ public:
         cin >> id;
         cin.ignore();
         
-        OrderNode* current = ordersHead;
-        while (current) {
-            if (current->order.id == id) {
-                double oldTotal = current->order.total;
-                
-                if (current->order.category == "drink") {
-                    cout << "Enter new liters: ";
-                    cin >> current->order.quantity;
-                    cin.ignore();
-                } else {
-                    string qty;
-                    while (true) {
-                        cout << "Enter new quantity: ";
-                        getline(cin, qty);
-                        bool valid = true;
-                        for (char c : qty) {
-                            if (!isdigit(c)) valid = false;
-                        }
-                        if (valid && !qty.empty()) {
-                            int quantity = stoi(qty);
-                            // ADDED: Validate food quantity doesn't exceed 60
-                            if (quantity > 60) {
-                                cout << "Cannot order more than 60 food items. Please enter a smaller quantity.\n";
-                                continue;
-                            }
-                            current->order.quantity = quantity;
-                            break;
-                        }
-                        cout << "Invalid quantity. Use digits only.\n";
-                    }
-                }
-                
-                for (const auto& item : menu) {
-                    if (item.second.first == current->order.item) {
-                        current->order.total = item.second.second.second * current->order.quantity;
-                        break;
-                    }
-                }
-                
-                double diff = current->order.total - oldTotal;
-                saveToFile();
-                cout << "Order " << id << " updated. New total: "
-                     << fixed << setprecision(2) << current->order.total << " birr.\n";
-                if (diff != 0) {
-                    cout << "Price changed by: " << fixed << setprecision(2) << abs(diff) 
-                         << " birr (" << (diff > 0 ? "+" : "") << diff << ")\n";
-                }
+        Order current;
+        vector<string> items;
+        if (!lookupOrder(id, current, items)) {
+            cout << "Order ID not found.\n";
+            return;
+        }
+        if (current.status == OrderStatus::Deleted) {
+            cout << "Order " << id << " is deleted.\n";
+            return;
+        }
+
+        size_t line = 0;
+        if (current.lines.size() > 1) {
+            for (size_t i = 0; i < items.size(); ++i) {
+                cout << i + 1 << ". " << items[i] << " x" << formatQuantity(current.lines[i].quantity) << "\n";
+            }
+            int choice;
+            cout << "Enter item number to update: ";
+            cin >> choice;
+            cin.ignore();
+            if (choice < 1 || static_cast<size_t>(choice) > current.lines.size()) {
+                cout << "Invalid item number.\n";
                 return;
             }
-            current = current->next;
+            line = static_cast<size_t>(choice - 1);
+        }
+
+        Quantity quantity = current.lines[line].category == Category::Drink
+            ? promptLiters("Enter new liters: ") : promptFoodQuantity("Enter new quantity: ");
+        
+        Order updated;
+        Money diff = 0;
+        string error;
+        if (!changeQuantity(id, line, quantity, updated, diff, error)) {
+            cout << error << "\n";
+            return;
+        }
+        cout << "Order " << id << " updated. New total: " << formatMoney(updated.total) << " birr.\n";
+        if (diff != 0) {
+            cout << "Price changed by: " << formatMoney(diff < 0 ? -diff : diff)
+                 << " birr (" << (diff > 0 ? "+" : "") << formatMoney(diff) << ")\n";
         }
-        cout << "Order ID not found.\n";
     } 
     
     void deleteOrderById() {
@@ -606,20 +4205,57 @@ public:
         cin >> id;
         cin.ignore();
         
-        OrderNode* current = ordersHead;
-        while (current) {
-            if (current->order.id == id) {
-                current->order.item = "[DELETED]";
-                current->order.quantity = 0;
-                current->order.total = 0.0;
-                saveToFile();
-                orderCount--;
-                cout << "Order " << id << " marked as deleted.\n";
-                return;
+        string error;
+        if (!cancelOrder(id, error)) {
+            cout << error << "\n";
+            return;
+        }
+        cout << "Order " << id << " marked as deleted.\n";
+    }
+
+    // Serves customers who do not know their order ID: a full name shows
+    // that customer's orders and spend, the start of a name lists the
+    // customers it matches.
+    void findCustomerOrders() const {
+        string name;
+        cout << "Enter customer name (or the start of it): ";
+        getline(cin, name);
+        if (name.empty()) {
+            cout << "Invalid name.\n";
+            return;
+        }
+        vector<CustomerHistory> matches = customersByPrefix(name, CUSTOMER_MATCHES_SHOWN + 1);
+        if (matches.empty()) {
+            cout << "No customer named " << name << ".\n";
+            return;
+        }
+        if (matches.size() > 1 && customerKey(matches[0].name) != customerKey(name)) {
+            TextBuffer out(cout);
+            out.str("\n------ Customers matching \"").str(name).str("\" ------").endLine();
+            out.str("Customer").pad(20).str("Orders").pad(10).str("Spent (birr)").endLine();
+            out.repeat('-', 45).endLine();
+            for (size_t i = 0; i < matches.size() && i < CUSTOMER_MATCHES_SHOWN; ++i) {
+                out.str(matches[i].name).pad(20).num(matches[i].orders).pad(10).money(matches[i].spend).endLine();
             }
-            current = current->next;
+            if (matches.size() > CUSTOMER_MATCHES_SHOWN) out.str("... and more.").endLine();
+            out.str("Enter a full name to see that customer's orders.").endLine();
+            return;
         }
-        cout << "Order ID not found.\n";
+
+        CustomerHistory customer;
+        vector<pair<Order, vector<string>>> history;
+        if (!customerOrders(matches[0].name, customer, history)) {
+            cout << "No customer named " << name << ".\n";
+            return;
+        }
+        TextBuffer out(cout);
+        out.str("\n------ Orders for ").str(customer.name).str(" ------").endLine();
+        writeOrderHeader(out);
+        for (const auto& entry : history) writeOrderRows(out, entry.first, &entry.second);
+        out.num(customer.orders).str(" order(s), spent ").money(customer.spend).str(" birr");
+        size_t deleted = history.size() - static_cast<size_t>(customer.orders);
+        if (deleted > 0) out.str(" (").num(static_cast<int64_t>(deleted)).str(" deleted)");
+        out.str(".").endLine();
     }
 
     void searchOrder() const {
@@ -628,67 +4264,151 @@ public:
         cin >> id;
         cin.ignore();
         
-        OrderNode* current = ordersHead;
-        while (current) {
-            if (current->order.id == id) {
-                const Order& o = current->order;
-                cout << "Found Order: " << o.customer << " ordered "
-                     << o.item << " x" << o.quantity << " at "
-                     << o.timestamp << ". Total: " << fixed << setprecision(2)
-                     << o.total << " birr.\n";
+        Order o;
+        vector<string> items;
+        bool archived = false;
+        if (!lookupOrder(id, o, items)) {
+            archived = lookupArchivedOrder(id, o, items);
+            if (!archived) {
+                cout << "Order ID not found.\n";
                 return;
             }
-            current = current->next;
         }
-        cout << "Order ID not found.\n";
+        cout << "Found Order: " << o.customer << " ordered at "
+             << formatTime(o.createdAt) << (archived ? " (archived)" : "") << ":\n";
+        for (size_t i = 0; i < items.size(); ++i) {
+            Quantity quantity = i < o.lines.size() ? o.lines[i].quantity : 0;
+            cout << "  " << items[i] << " x" << formatQuantity(quantity) << "\n";
+        }
+        cout << "Total: " << formatMoney(o.total) << " birr.\n";
     }
 
-    void sortOrders() {
-        ordersHead = mergeSort(ordersHead, compareByTime);
+    // Lists orders in time order straight from the time index; nothing is
+    // re-sorted or rewritten.
+    void sortOrders() const {
         cout << "Orders sorted by time.\n";
-        listOrders();
-        saveToFile();
+        listOrderPages(true, 0, LIST_PAGE_ROWS, consoleInput());
+    }
+
+    void listOrdersInRange() const {
+        string fromText, toText;
+        cout << "Enter start time (HH:MM or YYYY-MM-DD HH:MM): ";
+        getline(cin, fromText);
+        cout << "Enter end time (HH:MM or YYYY-MM-DD HH:MM): ";
+        getline(cin, toText);
+        string today = currentTime().substr(0, 10) + " ";
+        int64_t from, to;
+        if (!parseTime(fromText.size() <= 5 ? today + fromText : fromText, from) ||
+            !parseTime(toText.size() <= 5 ? today + toText : toText, to)) {
+            cout << "Invalid time.\n";
+            return;
+        }
+        // An end given to the minute includes that whole minute.
+        if (count(toText.begin(), toText.end(), ':') < 2) to += 59;
+        vector<pair<Order, vector<string>>> found = ordersBetween(from, to);
+        if (found.empty()) {
+            cout << "No orders in that time range.\n";
+            return;
+        }
+        Money total = 0;
+        TextBuffer out(cout);
+        out.str("\n------ Orders ").time(from).str(" to ").time(to).str(" ------").endLine();
+        writeOrderHeader(out);
+        for (const auto& entry : found) {
+            writeOrderRows(out, entry.first, &entry.second);
+            total += entry.first.total;
+        }
+        out.num(static_cast<int64_t>(found.size())).str(" order(s), total ").money(total)
+           .str(" birr.").endLine();
+    }
+
+    // Cashier view of salesBetween over whole local days.
+    void salesAnalytics() {
+        string fromText, toText;
+        cout << "Enter start date (YYYY-MM-DD): ";
+        getline(cin, fromText);
+        cout << "Enter end date (YYYY-MM-DD, blank for the same day): ";
+        getline(cin, toText);
+        if (toText.empty()) toText = fromText;
+        int64_t from, to;
+        if (!parseTime(fromText + " 00:00", from) || !parseTime(toText + " 00:00", to) || to < from) {
+            cout << "Invalid date range.\n";
+            return;
+        }
+        printSalesReport(fromText, toText, from, startOfDay(to + 26 * 3600), 5);
+    }
+
+    void printSalesReport(const string& fromDay, const string& toDay, int64_t from, int64_t to,
+                          size_t topK) {
+        auto started = chrono::steady_clock::now();
+        SalesReport report = salesBetween(from, to, topK);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+        const SalesTotals& t = report.totals;
+
+        TextBuffer out(cout);
+        out.str("\n====== Sales ").str(fromDay).str(" to ").str(toDay).str(" ======").endLine();
+        out.str("Orders: ").num(t.orders).endLine();
+        out.str("Revenue: ").money(t.revenue).str(" birr").endLine();
+        if (t.orders == 0) {
+            out.str("No sales in this range.").endLine();
+        } else {
+            out.endLine();
+            out.str("By hour:").endLine();
+            out.str("Hour").pad(8).str("Orders").pad(10).str("Revenue (birr)").endLine();
+            for (int h = 0; h < 24; ++h) {
+                if (t.hourOrders[h] == 0 && t.hourRevenue[h] == 0) continue;
+                out.str(h < 10 ? "0" : "").num(h).str(":00").pad(8).num(t.hourOrders[h]).pad(10)
+                   .money(t.hourRevenue[h]).endLine();
+            }
+            out.endLine();
+            out.str("By category:").endLine();
+            out.str("Category").pad(10).str("Quantity").pad(12).str("Revenue (birr)").endLine();
+            for (size_t c = 0; c < CATEGORY_COUNT; ++c) {
+                if (t.categoryQuantity[c] == 0 && t.categoryRevenue[c] == 0) continue;
+                out.str(categoryName(static_cast<Category>(c))).pad(10).quantity(t.categoryQuantity[c]).pad(12)
+                   .money(t.categoryRevenue[c]).endLine();
+            }
+            out.endLine();
+            out.str("Top ").num(static_cast<int64_t>(report.topItems.size())).str(" item(s) by revenue:").endLine();
+            out.str("Item").pad(20).str("Category").pad(10).str("Quantity").pad(12).str("Revenue (birr)").endLine();
+            for (const ItemTotal& item : report.topItems) {
+                out.str(item.name).pad(20).str(categoryName(item.category)).pad(10).quantity(item.quantity).pad(12)
+                   .money(item.revenue).endLine();
+            }
+        }
+        out.str("(").num(static_cast<int64_t>(report.rowsScanned)).str(" line item(s) scanned in ")
+           .fixed(static_cast<int64_t>(ms * 100 + 0.5), 2, 2).str(" ms)").endLine();
+        out.str("===============================").endLine();
     }
 
     void generateDailyReport() const {
+        OpTimer timer(metrics, Metric::DailyReport);
+        ReadGuard guard(storeLock);
         string today = currentTime().substr(0, 10);
-        double totalRevenue = 0.0;
-        int totalOrders = 0;
-        map<string, int> itemQuantities;
-        map<string, double> itemRevenues;
-
-        OrderNode* current = ordersHead;
-        while (current) {
-            const Order& o = current->order;
-            if (o.timestamp.substr(0, 10) == today && o.item != "[DELETED]") {
-                totalOrders++;
-                totalRevenue += o.total;
-                itemQuantities[o.item] += o.quantity;
-                itemRevenues[o.item] += o.total;
-            }
-            current = current->next;
-        }
-
-        cout << "\n====== Daily Sales Report ======\n";
-        cout << "Date: " << today << "\n";
-        cout << "Total Orders: " << totalOrders << "\n";
-        cout << "Total Revenue: " << fixed << setprecision(2) << totalRevenue << " birr\n\n";
+        auto day = dailySales.find(today);
+        int totalOrders = day == dailySales.end() ? 0 : day->second.orders;
+        Money totalRevenue = day == dailySales.end() ? 0 : day->second.revenue;
+
+        TextBuffer out(cout);
+        out.str("\n====== Daily Sales Report ======").endLine();
+        out.str("Date: ").str(today).endLine();
+        out.str("Total Orders: ").num(totalOrders).endLine();
+        out.str("Total Revenue: ").money(totalRevenue).str(" birr").endLine();
+        out.endLine();
         
-        if (!itemQuantities.empty()) {
-            cout << "Item-wise Sales:\n";
-            cout << left << setw(20) << "Item" << setw(10) << "Quantity" 
-                 << setw(15) << "Revenue (birr)" << endl;
-            cout << string(45, '-') << endl;
+        if (day != dailySales.end() && !day->second.items.empty()) {
+            out.str("Item-wise Sales:").endLine();
+            out.str("Item").pad(20).str("Quantity").pad(10).str("Revenue (birr)").pad(15).endLine();
+            out.repeat('-', 45).endLine();
             
-            for (const auto& item : itemQuantities) {
-                cout << left << setw(20) << item.first 
-                     << setw(10) << fixed << setprecision(2) << item.second 
-                     << setw(15) << itemRevenues[item.first] << endl;
+            for (const auto& item : day->second.items) {
+                out.str(itemName(item.first)).pad(20).quantity(item.second.quantity).pad(10)
+                   .money(item.second.revenue).pad(15).endLine();
             }
         } else {
-            cout << "No sales today.\n";
+            out.str("No sales today.").endLine();
         }
-        cout << "===============================\n";
+        out.str("===============================").endLine();
     }
     
     void submitFeedback() {
@@ -697,17 +4417,9 @@ public:
         cin >> orderId;
         cin.ignore();
 
-        bool orderExists = false;
-        OrderNode* current = ordersHead;
-        while (current) {
-            if (current->order.id == orderId && current->order.item != "[DELETED]") {
-                orderExists = true;
-                break;
-            }
-            current = current->next;
-        }
-
-        if (!orderExists) {
+        Order o;
+        vector<string> items;
+        if (!lookupOrder(orderId, o, items) || o.status == OrderStatus::Deleted) {
             cout << "Order ID not found or invalid.\n";
             return;
         }
@@ -716,74 +4428,173 @@ public:
         cout << "Enter your feedback: ";
         getline(cin, message);
 
-        if (message.empty()) {
-            cout << "Feedback cannot be empty.\n";
+        string error;
+        if (!addFeedback(orderId, message, error)) {
+            cout << error << "\n";
+            return;
+        }
+        cout << "Thank you for your feedback!\n";
+    }
+
+    void writeFeedbackHeader(TextBuffer& out, const char* title) const {
+        out.str("\n====== ").str(title).str(" ======").endLine();
+        out.str("Order ID").pad(10).str("Time").pad(20).str("Feedback").endLine();
+        out.repeat('-', 70).endLine();
+    }
+
+    void writeFeedbackRow(TextBuffer& out, const FeedbackRecord& fb) const {
+        out.num(fb.orderId).pad(10).str(fb.timestamp, fb.timestampLen).pad(20)
+           .str(fb.message, fb.messageLen).endLine();
+    }
+
+    void viewFeedbacks() const {
+        lock_guard<mutex> guard(feedbackMutex);
+        if (feedbacks.empty()) {
+            cout << "No feedback available.\n";
+            return;
+        }
+
+        TextBuffer out(cout);
+        writeFeedbackHeader(out, "Customer Feedbacks");
+        for (size_t i = 0; i < feedbacks.size(); ++i) {
+            writeFeedbackRow(out, feedbacks[i]);
+        }
+        out.str("===============================").endLine();
+    }
+
+    void viewOrderFeedback() const {
+        int orderId;
+        cout << "Enter Order ID: ";
+        cin >> orderId;
+        cin.ignore();
+
+        lock_guard<mutex> guard(feedbackMutex);
+        const vector<uint32_t>& slots = feedbacks.forOrder(orderId);
+        if (slots.empty()) {
+            cout << "No feedback for order " << orderId << ".\n";
+            return;
+        }
+        TextBuffer out(cout);
+        writeFeedbackHeader(out, "Order Feedback");
+        for (uint32_t slot : slots) writeFeedbackRow(out, feedbacks[slot]);
+        out.str("===============================").endLine();
+    }
+
+    // Finds feedback containing all the given words, e.g. "cold" or "late tibs".
+    void searchFeedbacks() const {
+        string query;
+        cout << "Search words: ";
+        getline(cin, query);
+
+        OpTimer timer(metrics, Metric::SearchFeedback);
+        lock_guard<mutex> guard(feedbackMutex);
+        vector<uint32_t> slots = feedbacks.search(query);
+        if (slots.empty()) {
+            cout << "No matching feedback.\n";
             return;
         }
+        TextBuffer out(cout);
+        writeFeedbackHeader(out, "Matching Feedback");
+        for (uint32_t slot : slots) writeFeedbackRow(out, feedbacks[slot]);
+        out.num(static_cast<int64_t>(slots.size())).str(" feedback(s) found.").endLine();
+    }
 
-        Feedback fb;
-        fb.orderId = orderId;
-        fb.message = message;
-        fb.timestamp = currentTime();
+    // Live kitchen queue for the chef. The open tickets are shown once, then
+    // new, changed and cancelled tickets are printed as the order core pushes
+    // them; nothing rescans the order list. Commands: "c <id>" starts
+    // cooking, "r <id>" marks ready, "0" goes back. On exit it reports the
+    // enqueue-to-display latency of the tickets it streamed.
+    void kitchenDisplay() {
+        KitchenEvent event;
+        kitchenFeed.drainWake();
+        while (kitchenFeed.pop(event)) {}
+        kitchenFeed.takeDropped();  // the open tickets below already cover them
+        set<int> shown;
+        vector<pair<int, string>> open = openTickets();
+        cout << "\n====== Kitchen Display ======\n";
+        if (open.empty()) cout << "No open tickets.\n";
+        for (const auto& ticket : open) {
+            shown.insert(ticket.first);
+            cout << ticket.second;
+        }
+        cout << "Commands: c <id> = start cooking, r <id> = ready, 0 = back\n" << flush;
 
-        FeedbackNode* newNode = new FeedbackNode{fb, nullptr};
-        if (!feedbacksHead) {
-            feedbacksHead = newNode;
-        } else {
-            FeedbackNode* currentFB = feedbacksHead;
-            while (currentFB->next) {
-                currentFB = currentFB->next;
+        vector<double> latencies;
+        auto showEvents = [&]() {
+            kitchenFeed.drainWake();
+            while (kitchenFeed.pop(event)) {
+                if (event.kind == KitchenEvent::New && !shown.insert(event.orderId).second) continue;
+                if (event.kind == KitchenEvent::Cancelled) {
+                    if (!shown.erase(event.orderId)) continue;
+                    cout << "CANCELLED #" << event.orderId << "\n";
+                } else {
+                    cout << (event.kind == KitchenEvent::New ? "NEW " : "CHANGED ") << event.text;
+                }
+                cout << flush;
+                latencies.push_back((steadyNanos() - event.queuedNs) / 1000.0);
             }
-            currentFB->next = newNode;
-        }
-        
-        saveFeedback(fb);
-        cout << "Thank you for your feedback!\n";
-    }
+        };
 
-    void viewFeedbacks() const {
-        if (!feedbacksHead) {
-            cout << "No feedback available.\n";
-            return;
+        // With a terminal, wait on both the keyboard and the feed; piped
+        // input is read line by line, catching up on the feed in between.
+        bool interactive = consoleInput();
+        while (true) {
+            if (interactive) {
+                pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {kitchenFeed.wakeFd(), POLLIN, 0}};
+                if (poll(fds, 2, -1) < 0) {
+                    if (errno == EINTR) continue;
+                    break;
+                }
+                showEvents();
+                if (!(fds[0].revents & (POLLIN | POLLHUP))) continue;
+            } else {
+                showEvents();
+            }
+            string command;
+            if (!getline(cin, command) || command == "0") break;
+            istringstream in(command);
+            char action = 0;
+            int id = 0;
+            in >> action >> id;
+            KitchenState next = action == 'c' ? KitchenState::Cooking : KitchenState::Ready;
+            string error;
+            if ((action != 'c' && action != 'r') || !in) {
+                cout << "Use c <id>, r <id> or 0.\n";
+            } else if (!advanceKitchen(id, next, error)) {
+                cout << error << "\n";
+            } else {
+                cout << "#" << id << " is now " << kitchenStateName(next) << ".\n";
+                if (next == KitchenState::Ready) shown.erase(id);
+            }
         }
 
-        cout << "\n====== Customer Feedbacks ======\n";
-        cout << left << setw(10) << "Order ID" << setw(20) << "Time" << "Feedback" << endl;
-        cout << string(70, '-') << endl;
-        
-        FeedbackNode* current = feedbacksHead;
-        while (current) {
-            const Feedback& fb = current->feedback;
-            cout << left << setw(10) << fb.orderId 
-                 << setw(20) << fb.timestamp 
-                 << fb.message << endl;
-            current = current->next;
+        if (!latencies.empty()) {
+            sort(latencies.begin(), latencies.end());
+            int64_t p50 = static_cast<int64_t>(latencies[latencies.size() / 2] * 10 + 0.5);
+            int64_t worst = static_cast<int64_t>(latencies.back() * 10 + 0.5);
+            cout << "Streamed " << latencies.size() << " update(s); enqueue-to-display latency p50 "
+                 << formatFixed(p50, 1, 1) << " us, max " << formatFixed(worst, 1, 1) << " us.\n";
+        }
+        size_t dropped = kitchenFeed.takeDropped();
+        if (dropped > 0) {
+            cout << dropped << " kitchen update(s) were dropped while this display was open; "
+                 << "reopen it for the current tickets.\n";
         }
-        cout << "===============================\n";
     }
 
     void displayFamousFood() const {
-        if (!ordersHead) {
-            cout << "** Most Popular Food: (No orders yet) **\n";
-            return;
-        }
-        map<string, double> itemCount;
-        OrderNode* current = ordersHead;
-        while (current) {
-            if (current->order.item != "[DELETED]" && current->order.category == "food") {
-                itemCount[current->order.item] += current->order.quantity;
+        string item;
+        Quantity units = 0;
+        if (!popularFood(item, units)) {
+            ReadGuard guard(storeLock);
+            if (orders.empty() && dailySales.empty()) {
+                cout << "** Most Popular Food: (No orders yet) **\n";
+            } else {
+                cout << "** Most Popular Food: (No valid orders) **\n";
             }
-            current = current->next;
-        }
-        if (itemCount.empty()) {
-            cout << "** Most Popular Food: (No valid orders) **\n";
             return;
         }
-        auto best = max_element(itemCount.begin(), itemCount.end(),
-                [](const pair<string, double>& a, const pair<string, double>& b) {
-                    return a.second < b.second;
-                });
-        cout << "** Most Popular Food: " << best->first << " (Sold " << best->second << " units) **\n";
+        cout << "** Most Popular Food: " << item << " (Sold " << formatQuantity(units) << " units) **\n";
     }
 }; 
 
@@ -798,6 +4609,10 @@ void showCashierMenu() {
     cout << "7. Update Menu\n";
     cout << "8. Daily Sales Report\n";
     cout << "9. Change Password\n";
+    cout << "10. Orders by Time Range\n";
+    cout << "11. Sales Analytics\n";
+    cout << "12. Performance Metrics\n";
+    cout << "13. Find Orders by Customer\n";
     cout << "0. Exit\n";
     cout << "Choose: ";
 }
@@ -816,14 +4631,616 @@ void showCustomerMenu() {
 void showChefMenu() {
     cout << "\n=== Chef Menu ===\n";
     cout << "1. View Feedbacks\n";
-    cout << "2. List Orders\n";
+    cout << "2. Kitchen Display\n";
     cout << "3. Change Password\n";
+    cout << "4. List All Orders\n";
+    cout << "5. Feedback for an Order\n";
+    cout << "6. Search Feedbacks\n";
     cout << "0. Back\n";
     cout << "Choose: ";
 }
 
-int main() {
-    OrderManager sharedOM;
+// Reads a flat JSON object such as {"item": 3, "quantity": 2, "customer": "Abebe"}
+// into key -> raw value (strings unescaped, numbers left as text).
+bool parseJsonObject(const string& line, map<string, string>& fields) {
+    size_t i = line.find('{');
+    if (i == string::npos) return false;
+    auto skipSpace = [&]() { while (i < line.size() && isspace(static_cast<unsigned char>(line[i]))) i++; };
+    auto readString = [&](string& out) {
+        if (i >= line.size() || line[i] != '"') return false;
+        for (i++; i < line.size() && line[i] != '"'; i++) {
+            if (line[i] == '\\' && i + 1 < line.size()) i++;
+            out += line[i];
+        }
+        if (i >= line.size()) return false;
+        i++;
+        return true;
+    };
+    i++;
+    while (true) {
+        skipSpace();
+        if (i < line.size() && line[i] == '}') return true;
+        string key, value;
+        if (!readString(key)) return false;
+        skipSpace();
+        if (i >= line.size() || line[i] != ':') return false;
+        i++;
+        skipSpace();
+        if (i < line.size() && line[i] == '"') {
+            if (!readString(value)) return false;
+        } else {
+            while (i < line.size() && line[i] != ',' && line[i] != '}' &&
+                   !isspace(static_cast<unsigned char>(line[i]))) {
+                value += line[i++];
+            }
+        }
+        fields[key] = value;
+        skipSpace();
+        if (i < line.size() && line[i] == ',') {
+            i++;
+        } else if (i < line.size() && line[i] == '}') {
+            return true;
+        } else {
+            return false;
+        }
+    }
+}
+
+// Accepts either "menuId,quantity[,menuId,quantity ...],customer" CSV or one
+// JSON object per line with "item", "quantity" and "customer" keys (one item).
+bool parseOrderRequest(const string& line, OrderRequest& req, string& error) {
+    vector<string> fields;
+    if (line.find('{') != string::npos) {
+        map<string, string> object;
+        if (!parseJsonObject(line, object)) {
+            error = "Malformed JSON record.";
+            return false;
+        }
+        fields.push_back(object["item"]);
+        fields.push_back(object["quantity"]);
+        fields.push_back(object["customer"]);
+    } else {
+        stringstream ss(line);
+        string field;
+        while (getline(ss, field, ',')) fields.push_back(field);
+        if (!line.empty() && line.back() == ',') fields.push_back("");
+    }
+    if (fields.size() < 3 || fields.size() % 2 == 0) {
+        error = "Expected menu ID and quantity pairs followed by the customer name.";
+        return false;
+    }
+    req.customer = fields.back();
+    req.items.clear();
+    for (size_t i = 0; i + 1 < fields.size(); i += 2) {
+        int menuId;
+        Quantity quantity;
+        if (!parseInt(fields[i], menuId)) {
+            error = "Invalid menu ID.";
+            return false;
+        }
+        if (!parseFixed(fields[i + 1], QUANTITY_DIGITS, quantity)) {
+            error = "Invalid quantity. Use digits only.";
+            return false;
+        }
+        req.items.push_back(make_pair(menuId, quantity));
+    }
+    return true;
+}
+
+// Bulk order ingestion: reads records from a file (or stdin for "-") and
+// commits them batchSize at a time, one journal flush per batch.
+int runBatchImport(OrderManager& om, const string& source, size_t batchSize) {
+    ifstream file;
+    if (source != "-") {
+        file.open(source);
+        if (!file) {
+            cout << "Cannot open " << source << ".\n";
+            return 1;
+        }
+    }
+    istream& in = source == "-" ? cin : file;
+
+    auto started = chrono::steady_clock::now();
+    vector<OrderRequest> batch;
+    batch.reserve(batchSize);
+    vector<pair<int, string>> rejected;
+    size_t accepted = 0;
+    string unsaved;
+    string line;
+    int lineNo = 0;
+    while (getline(in, line)) {
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        OrderRequest req;
+        string error;
+        req.line = lineNo;
+        if (!parseOrderRequest(line, req, error)) {
+            // A non-numeric first CSV line is a header row.
+            if (lineNo == 1 && line.find('{') == string::npos) continue;
+            rejected.push_back(make_pair(lineNo, error));
+            continue;
+        }
+        batch.push_back(req);
+        if (batch.size() >= batchSize) {
+            accepted += om.placeOrders(batch, rejected, &unsaved);
+            batch.clear();
+        }
+    }
+    if (!batch.empty()) accepted += om.placeOrders(batch, rejected, &unsaved);
+    om.refreshCapacity();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    sort(rejected.begin(), rejected.end());
+    const size_t shown = 20;
+    for (size_t i = 0; i < rejected.size() && i < shown; ++i) {
+        cout << "Line " << rejected[i].first << ": " << rejected[i].second << "\n";
+    }
+    if (rejected.size() > shown) {
+        cout << "... and " << rejected.size() - shown << " more rejected line(s).\n";
+    }
+    cout << "Imported " << accepted << " order(s), rejected " << rejected.size()
+         << ", in " << fixed << setprecision(3) << seconds << " s ("
+         << setprecision(0) << (seconds > 0 ? accepted / seconds : 0.0) << " orders/sec).\n";
+    if (!unsaved.empty()) cout << "Warning: " << unsaved << "\n";
+    return rejected.empty() && unsaved.empty() ? 0 : 2;
+}
+
+// Discards everything written to it; used to time screen output paths
+// without a terminal in the way.
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+// Latency samples for one operation, in microseconds. Throughput is
+// samples over their summed latency, or over wallSeconds when the samples
+// were taken concurrently.
+void printLatency(const string& name, vector<double>& samples, double wallSeconds = 0) {
+    if (samples.empty()) return;
+    sort(samples.begin(), samples.end());
+    auto pct = [&](double p) {
+        return samples[min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+    };
+    double total = 0;
+    for (double s : samples) total += s;
+    cout << left << setw(22) << name << right << setw(8) << samples.size()
+         << fixed << setprecision(1)
+         << setw(12) << pct(0.50) << setw(12) << pct(0.90)
+         << setw(12) << pct(0.99) << setw(12) << samples.back()
+         << setw(14) << setprecision(0) << samples.size() / (wallSeconds > 0 ? wallSeconds : total / 1e6) << "\n";
+}
+
+template <typename Op>
+vector<double> timeOp(size_t runs, Op op) {
+    vector<double> samples;
+    samples.reserve(runs);
+    for (size_t i = 0; i < runs; ++i) {
+        auto start = chrono::steady_clock::now();
+        op(i);
+        samples.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    }
+    return samples;
+}
+
+int removeBenchFile(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+// Drives OrderManager against synthetic datasets of 1k orders and up
+// (x10 per step, up to maxOrders) in a scratch directory and prints
+// per-operation latency percentiles and throughput.
+int runBenchmark(size_t maxOrders) {
+    char dir[] = "/tmp/order-bench-XXXXXX";
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd)) || !mkdtemp(dir) || chdir(dir) != 0) {
+        cout << "Cannot create a scratch directory for the benchmark.\n";
+        return 1;
+    }
+    setenv("ORDER_METRICS_INTERVAL", "0", 1);
+    if (!getenv("ORDER_MEMORY_BUDGET_MB")) {
+        setenv("ORDER_MEMORY_BUDGET_MB", to_string(max<size_t>(256, maxOrders / 2000)).c_str(), 1);
+    }
+
+    NullBuffer nullBuffer;
+    streambuf* console = cout.rdbuf(&nullBuffer);
+    OrderManager* om = new OrderManager();
+    cout.rdbuf(console);
+
+    const char* names[] = {"Abebe", "Sara", "Kebede", "Hana", "Dawit", "Meron", "Yonas", "Liya"};
+    const size_t fastRuns = 1000, slowRuns = 3;
+    unsigned seed = 12345;
+    auto nextRandom = [&seed]() { seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7fff; };
+    size_t loaded = 0;
+    vector<pair<int, string>> rejected;
+
+    for (size_t target = 1000; target <= maxOrders; target *= 10) {
+        auto fillStart = chrono::steady_clock::now();
+        vector<OrderRequest> batch;
+        while (loaded < target) {
+            batch.clear();
+            for (size_t i = 0; i < 10000 && loaded + batch.size() < target; ++i) {
+                OrderRequest req;
+                req.items.assign(1, make_pair(static_cast<int>(nextRandom() % 5) + 1,
+                                              static_cast<Quantity>(nextRandom() % 9 + 1) * QUANTITY_ONE));
+                req.customer = names[nextRandom() % 8];
+                req.line = 0;
+                batch.push_back(req);
+            }
+            loaded += om->placeOrders(batch, rejected);
+        }
+        double fillSeconds = chrono::duration<double>(chrono::steady_clock::now() - fillStart).count();
+
+        cout << "\n== " << target << " orders (bulk load " << fixed << setprecision(2)
+             << fillSeconds << " s) ==\n";
+        cout << left << setw(22) << "operation" << right << setw(8) << "runs"
+             << setw(12) << "p50 (us)" << setw(12) << "p90 (us)" << setw(12) << "p99 (us)"
+             << setw(12) << "max (us)" << setw(14) << "ops/sec" << "\n";
+
+        Order o;
+        vector<string> items;
+        string error;
+        Money diff;
+        int firstId = 1001;
+        int lastId = firstId + static_cast<int>(loaded) - 1;
+        auto randomId = [&]() { return firstId + static_cast<int>((nextRandom() * 32768u + nextRandom()) % loaded); };
+
+        // A stand-in kitchen display drains the feed while orders are
+        // created, timing each ticket from enqueue to pop.
+        KitchenFeed& feed = om->kitchen();
+        KitchenEvent event;
+        feed.drainWake();
+        while (feed.pop(event)) {}
+        vector<double> kitchenLatency;
+        atomic<bool> creating(true);
+        thread display([&]() {
+            while (true) {
+                bool last = !creating.load();
+                pollfd fd = {feed.wakeFd(), POLLIN, 0};
+                poll(&fd, 1, 10);
+                feed.drainWake();
+                while (feed.pop(event)) {
+                    kitchenLatency.push_back((steadyNanos() - event.queuedNs) / 1000.0);
+                }
+                if (last) break;
+            }
+        });
+        auto samples = timeOp(fastRuns, [&](size_t) {
+            vector<pair<int, Quantity>> ticket(1, make_pair(static_cast<int>(nextRandom() % 5) + 1, 2 * QUANTITY_ONE));
+            om->placeOrder(ticket, "Bench Guest", o, error);
+        });
+        creating = false;
+        display.join();
+        loaded += fastRuns;
+        printLatency("create", samples);
+        printLatency("kitchen feed", kitchenLatency);
+
+        // The same load from several tills at once; their journal records
+        // share group commits.
+        const size_t tills = 8;
+        vector<vector<double>> tillSamples(tills);
+        vector<thread> tillThreads;
+        auto tillsStart = chrono::steady_clock::now();
+        for (size_t t = 0; t < tills; ++t) {
+            tillThreads.push_back(thread([&, t]() {
+                Order placed;
+                string tillError;
+                vector<pair<int, Quantity>> ticket(1, make_pair(static_cast<int>(t % 5) + 1, 2 * QUANTITY_ONE));
+                tillSamples[t] = timeOp(fastRuns / tills, [&](size_t) { om->placeOrder(ticket, "Bench Guest", placed, tillError); });
+            }));
+        }
+        samples.clear();
+        for (size_t t = 0; t < tills; ++t) {
+            tillThreads[t].join();
+            samples.insert(samples.end(), tillSamples[t].begin(), tillSamples[t].end());
+        }
+        double tillSeconds = chrono::duration<double>(chrono::steady_clock::now() - tillsStart).count();
+        loaded += fastRuns / tills * tills;
+        printLatency("create (8 tills)", samples, tillSeconds);
+        feed.drainWake();
+        while (feed.pop(event)) {}
+
+        samples = timeOp(fastRuns, [&](size_t) { om->lookupOrder(randomId(), o, items); });
+        printLatency("search", samples);
+        samples = timeOp(fastRuns, [&](size_t) { om->changeQuantity(randomId(), 0, 3 * QUANTITY_ONE, o, diff, error); });
+        printLatency("update", samples);
+        const char* remarks[] = {"food was cold", "delivery was late", "great tibs", "too salty", "friendly staff"};
+        samples = timeOp(fastRuns, [&](size_t) { om->addFeedback(randomId(), remarks[nextRandom() % 5], error); });
+        printLatency("feedback submit", samples);
+        samples = timeOp(fastRuns, [&](size_t) { om->feedbackFor(randomId()); });
+        printLatency("feedback by order", samples);
+        samples = timeOp(fastRuns, [&](size_t) { om->searchFeedback("was late"); });
+        printLatency("feedback search", samples);
+        samples = timeOp(fastRuns, [&](size_t i) { om->cancelOrder(lastId - static_cast<int>(i), error); });
+        printLatency("delete", samples);
+
+        string itemName;
+        Category category;
+        Money price;
+        samples = timeOp(fastRuns, [&](size_t i) { om->menuItem(static_cast<int>(i % 5) + 1, itemName, category, price); });
+        printLatency("menu item lookup", samples);
+
+        cout.rdbuf(&nullBuffer);
+        vector<double> menuScreen = timeOp(fastRuns, [&](size_t) { om->displayMenu(); });
+        vector<double> famous = timeOp(fastRuns, [&](size_t) { om->displayFamousFood(); });
+        vector<double> report = timeOp(fastRuns, [&](size_t) { om->generateDailyReport(); });
+        vector<double> analytics = timeOp(slowRuns, [&](size_t) { om->salesBetween(0, INT64_MAX, 10); });
+        vector<double> listing = timeOp(slowRuns, [&](size_t) { om->listOrderPages(false, 0, LIST_PAGE_ROWS, false); });
+        vector<double> sorting = timeOp(slowRuns, [&](size_t) { om->listOrderPages(true, 0, LIST_PAGE_ROWS, false); });
+        vector<double> saving = timeOp(slowRuns, [&](size_t) { om->checkpoint(); });
+        vector<double> loading = timeOp(slowRuns, [&](size_t) { delete new OrderManager(); });
+        cout.rdbuf(console);
+        printLatency("displayMenu", menuScreen);
+        printLatency("displayFamousFood", famous);
+        printLatency("generateDailyReport", report);
+        printLatency("salesBetween (all)", analytics);
+        printLatency("listOrders", listing);
+        printLatency("sortOrders", sorting);
+        printLatency("save (checkpoint)", saving);
+        printLatency("load (startup)", loading);
+    }
+
+    cout.rdbuf(&nullBuffer);
+    delete om;
+    cout.rdbuf(console);
+    if (chdir(cwd) != 0) return 1;
+    nftw(dir, removeBenchFile, 16, FTW_DEPTH | FTW_PHYS);
+    return 0;
+}
+
+// Line-oriented order service on a Unix socket, one thread per connected
+// till. Each request is one line and gets one reply line ("OK ..." or
+// "ERR <message>"), except MENU, which replies "OK <n>" followed by n lines,
+// and SEARCH, which replies "OK <id>,<customer>,<total>,<time>,<n>" followed
+// by n "<item>,<category>,<quantity>,<unit price>" lines. A till that sends
+// more than MAX_REQUEST_LINE bytes without a newline is disconnected.
+//   MENU
+//   ORDER <menu id> <quantity> [<menu id> <quantity> ...] <customer name>
+//   SEARCH <order id>
+//   UPDATE <order id> [<item number>] <quantity>
+//   DELETE <order id>
+//   POPULAR
+//   LOGIN <cashier password>      (enables REPORT)
+//   REPORT
+//   QUIT
+class OrderServer {
+public:
+    OrderServer(OrderManager& om, const string& path)
+        : om(om), socketPath(path), listenFd(-1), running(false) {}
+
+    ~OrderServer() { stop(); }
+
+    bool start() {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(addr.sun_path)) {
+            cout << "Socket path too long: " << socketPath << "\n";
+            return false;
+        }
+        strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(socketPath.c_str());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0 ||
+            bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listenFd, SOMAXCONN) != 0) {
+            cout << "Cannot listen on " << socketPath << ".\n";
+            if (listenFd >= 0) close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+        running = true;
+        acceptThread = thread(&OrderServer::acceptLoop, this);
+        cout << "Serving tills on " << socketPath << ".\n";
+        return true;
+    }
+
+    void stop() {
+        if (!running.exchange(false)) return;
+        shutdown(listenFd, SHUT_RDWR);
+        close(listenFd);
+        acceptThread.join();
+
+        unique_lock<mutex> lock(sessionsMutex);
+        for (int fd : clientFds) shutdown(fd, SHUT_RDWR);
+        sessionsDone.wait(lock, [this] { return clientFds.empty(); });
+        unlink(socketPath.c_str());
+    }
+
+private:
+    OrderManager& om;
+    string socketPath;
+    int listenFd;
+    atomic<bool> running;
+    thread acceptThread;
+    mutex sessionsMutex;
+    condition_variable sessionsDone;
+    set<int> clientFds;
+
+    void acceptLoop() {
+        while (running) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            lock_guard<mutex> lock(sessionsMutex);
+            clientFds.insert(fd);
+            thread(&OrderServer::serveClient, this, fd).detach();
+        }
+    }
+
+    void serveClient(int fd) {
+        bool cashier = false;
+        string buffer;
+        char chunk[4096];
+        bool open = true;
+        while (open) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) break;
+            buffer.append(chunk, static_cast<size_t>(n));
+            size_t start = 0, newline;
+            while ((newline = buffer.find('\n', start)) != string::npos) {
+                string line = buffer.substr(start, newline - start);
+                start = newline + 1;
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                string reply;
+                open = handle(line, cashier, reply);
+                if (!sendAll(fd, reply) || !open) {
+                    open = false;
+                    break;
+                }
+            }
+            buffer.erase(0, start);
+            if (open && buffer.size() > MAX_REQUEST_LINE) {
+                sendAll(fd, "ERR request line too long\n");
+                open = false;
+            }
+        }
+        // Forget the fd before closing it: once closed its number can be
+        // reused, and stop() must not shut down someone else's file.
+        {
+            lock_guard<mutex> lock(sessionsMutex);
+            clientFds.erase(fd);
+            sessionsDone.notify_all();
+        }
+        close(fd);
+    }
+
+    static bool sendAll(int fd, const string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Builds the reply for one request line; returns false when the session ends.
+    bool handle(const string& line, bool& cashier, string& reply) {
+        istringstream in(line);
+        string cmd;
+        in >> cmd;
+        transform(cmd.begin(), cmd.end(), cmd.begin(), ::toupper);
+        ostringstream out;
+        string error;
+
+        if (cmd == "QUIT") {
+            reply = "OK bye\n";
+            return false;
+        } else if (cmd == "MENU") {
+            string listing = om.menuListing();
+            size_t lines = count(listing.begin(), listing.end(), '\n');
+            out << "OK " << lines << "\n" << listing;
+        } else if (cmd == "ORDER") {
+            // (menu id, quantity) pairs run until the first non-numeric
+            // token, which starts the customer name.
+            vector<pair<int, Quantity>> items;
+            int menuId;
+            Quantity quantity;
+            string customer, quantityText;
+            bool paired = true;
+            while (in >> menuId) {
+                if (!(in >> quantityText) || !parseFixed(quantityText, QUANTITY_DIGITS, quantity)) {
+                    paired = false;
+                    break;
+                }
+                items.push_back(make_pair(menuId, quantity));
+            }
+            in.clear();
+            if (!paired || items.empty()) {
+                out << "ERR usage: ORDER <menu id> <quantity> [<menu id> <quantity> ...] <customer name>\n";
+            } else {
+                getline(in >> ws, customer);
+                Order o;
+                if (om.placeOrder(items, customer, o, error)) {
+                    out << "OK " << o.id << " " << formatMoney(o.total) << " " << formatTime(o.createdAt) << "\n";
+                } else {
+                    out << "ERR " << error << "\n";
+                }
+            }
+        } else if (cmd == "SEARCH") {
+            int id;
+            Order o;
+            vector<string> items;
+            if (!(in >> id)) {
+                out << "ERR usage: SEARCH <order id>\n";
+            } else if (om.lookupOrder(id, o, items)) {
+                out << "OK " << o.id << "," << o.customer << "," << formatMoney(o.total) << ","
+                    << formatTime(o.createdAt) << "," << o.lines.size() << "\n";
+                for (size_t i = 0; i < o.lines.size(); ++i) {
+                    const OrderLine& line = o.lines[i];
+                    out << items[i] << "," << categoryName(line.category) << ","
+                        << formatQuantity(line.quantity) << "," << formatMoney(line.unitPrice) << "\n";
+                }
+            } else {
+                out << "ERR Order ID not found.\n";
+            }
+        } else if (cmd == "UPDATE") {
+            int id;
+            string first, second;
+            Quantity quantity;
+            Money diff = 0;
+            int64_t itemNumber = 1;
+            Order o;
+            bool parsed = static_cast<bool>(in >> id >> first);
+            if (parsed && in >> second) {
+                parsed = parseFixed(first, 0, itemNumber) && itemNumber >= 1 &&
+                         parseFixed(second, QUANTITY_DIGITS, quantity);
+            } else if (parsed) {
+                parsed = parseFixed(first, QUANTITY_DIGITS, quantity);
+            }
+            if (!parsed) {
+                out << "ERR usage: UPDATE <order id> [<item number>] <quantity>\n";
+            } else if (om.changeQuantity(id, static_cast<size_t>(itemNumber - 1), quantity, o, diff, error)) {
+                out << "OK " << o.id << " " << formatMoney(o.total) << " " << formatMoney(diff) << "\n";
+            } else {
+                out << "ERR " << error << "\n";
+            }
+        } else if (cmd == "DELETE") {
+            int id;
+            if (!(in >> id)) {
+                out << "ERR usage: DELETE <order id>\n";
+            } else if (om.cancelOrder(id, error)) {
+                out << "OK " << id << "\n";
+            } else {
+                out << "ERR " << error << "\n";
+            }
+        } else if (cmd == "POPULAR") {
+            string item;
+            Quantity units;
+            if (om.popularFood(item, units)) {
+                out << "OK " << formatQuantity(units) << " " << item << "\n";
+            } else {
+                out << "ERR No valid orders.\n";
+            }
+        } else if (cmd == "LOGIN") {
+            string password;
+            getline(in >> ws, password);
+            cashier = om.verifyPassword(password);
+            out << (cashier ? "OK cashier\n" : "ERR Wrong password.\n");
+        } else if (cmd == "REPORT") {
+            if (!cashier) {
+                out << "ERR Cashier login required.\n";
+            } else {
+                string day;
+                int totalOrders;
+                Money totalRevenue;
+                om.todaySales(day, totalOrders, totalRevenue);
+                out << "OK " << day << " " << totalOrders << " " << formatMoney(totalRevenue) << "\n";
+            }
+        } else {
+            out << "ERR Unknown command.\n";
+        }
+        reply = out.str();
+        return true;
+    }
+};
+
+void runConsole(OrderManager& om) {
     while (true) {
         cout << "Select role:\n1. Customer\n2. Cashier\n3. Chef\n0. Exit\nChoice: ";
         int role;
@@ -833,18 +5250,18 @@ int main() {
         if (role == 0) break;
         if (role == 1) {
             while (true) {
-                sharedOM.displayFamousFood();
+                om.displayFamousFood();
                 showCustomerMenu();
                 int c;
                 cin >> c;
                 cin.ignore();
                 if (c == 0) break;
                 switch(c) {
-                    case 1: sharedOM.createOrder(); break;
-                    case 2: sharedOM.searchOrder(); break;
-                    case 3: sharedOM.updateOrderById(); break;
-                    case 4: sharedOM.deleteOrderById(); break;
-                    case 5: sharedOM.submitFeedback(); break;
+                    case 1: om.createOrder(); break;
+                    case 2: om.searchOrder(); break;
+                    case 3: om.updateOrderById(); break;
+                    case 4: om.deleteOrderById(); break;
+                    case 5: om.submitFeedback(); break;
                     default: cout << "Invalid choice.\n";
                 }
             }
@@ -852,27 +5269,31 @@ int main() {
         else if (role == 2) {
             cout << "Enter cashier password: ";
             string pwd = getPassword();
-            if (!sharedOM.verifyPassword(pwd)) {
+            if (!om.verifyPassword(pwd)) {
                 cout << "\nWrong password.\n";
                 continue;
             }
             while (true) {
-                sharedOM.displayFamousFood();
+                om.displayFamousFood();
                 showCashierMenu();
                 int choice;
                 cin >> choice;
                 cin.ignore();
                 if (choice == 0) break;
                 switch (choice) {
-                    case 1: sharedOM.createOrder(); break;
-                    case 2: sharedOM.listOrders(); break;
-                    case 3: sharedOM.updateOrderById(); break;
-                    case 4: sharedOM.deleteOrderById(); break;
-                    case 5: sharedOM.searchOrder(); break;
-                    case 6: sharedOM.sortOrders(); break;
-                    case 7: sharedOM.updateMenu(); break;
-                    case 8: sharedOM.generateDailyReport(); break;
-                    case 9: sharedOM.changePassword(); break;
+                    case 1: om.createOrder(); break;
+                    case 2: om.listOrders(); break;
+                    case 3: om.updateOrderById(); break;
+                    case 4: om.deleteOrderById(); break;
+                    case 5: om.searchOrder(); break;
+                    case 6: om.sortOrders(); break;
+                    case 7: om.updateMenu(); break;
+                    case 8: om.generateDailyReport(); break;
+                    case 9: om.changePassword(); break;
+                    case 10: om.listOrdersInRange(); break;
+                    case 11: om.salesAnalytics(); break;
+                    case 12: om.showMetrics(); break;
+                    case 13: om.findCustomerOrders(); break;
                     default: cout << "Invalid choice.\n";
                 }
             }
@@ -880,7 +5301,7 @@ int main() {
         else if (role == 3) {
             cout << "Enter chef password: ";
             string pwd = getPassword();
-            if (!sharedOM.verifyPassword(pwd, false)) {
+            if (!om.verifyPassword(pwd, false)) {
                 cout << "\nWrong password.\n";
                 continue;
             }
@@ -891,9 +5312,12 @@ int main() {
                 cin.ignore();
                 if (choice == 0) break;
                 switch (choice) {
-                    case 1: sharedOM.viewFeedbacks(); break;
-                    case 2: sharedOM.listOrders(); break;
-                    case 3: sharedOM.changePassword(false); break;
+                    case 1: om.viewFeedbacks(); break;
+                    case 2: om.kitchenDisplay(); break;
+                    case 3: om.changePassword(false); break;
+                    case 4: om.listOrders(); break;
+                    case 5: om.viewOrderFeedback(); break;
+                    case 6: om.searchFeedbacks(); break;
                     default: cout << "Invalid choice.\n";
                 }
             }
@@ -902,6 +5326,510 @@ int main() {
             cout << "Invalid role selected.\n";
         }
     }
+}
+
+// One console session: the role it logs in as and every line the user
+// types, from role selection through Back and Exit.
+struct ConsoleSession {
+    int role;  // 1 customer, 2 cashier, 3 chef
+    string input;
+};
+
+const char* const SESSION_ROLES[] = {"", "customer", "cashier", "chef"};
+const char* const SESSION_CUSTOMERS[] = {"Abebe", "Sara", "Kebede", "Hana", "Dawit", "Meron", "Yonas", "Liya"};
+
+// Synthesizes console sessions with a fixed random seed. It tracks the
+// tickets its own sessions create (IDs are handed out from 1001 in a fresh
+// store) so later sessions search, update, delete, cook and leave feedback
+// on orders that exist, and answers every follow-up prompt those screens ask.
+class SessionGenerator {
+public:
+    SessionGenerator(const vector<pair<int, Category>>& items, const unsigned mix[3], unsigned seed)
+        : items(items), seed(seed), nextOrderId(1001) {
+        for (int i = 0; i < 3; ++i) weights[i] = mix[i];
+    }
+
+    ConsoleSession next() {
+        ConsoleSession session;
+        unsigned pick = random() % max(1u, weights[0] + weights[1] + weights[2]);
+        session.role = pick < weights[0] ? 1 : pick < weights[0] + weights[1] ? 2 : 3;
+        ostringstream in;
+        in << session.role << "\n";
+        if (session.role != 1) in << "123\n";
+        int actions = 1 + static_cast<int>(random() % 3);
+        for (int i = 0; i < actions; ++i) {
+            if (session.role == 1) {
+                customerAction(in);
+            } else if (session.role == 2) {
+                cashierAction(in);
+            } else {
+                chefAction(in);
+            }
+        }
+        in << "0\n0\n";
+        session.input = in.str();
+        return session;
+    }
+
+private:
+    vector<pair<int, Category>> items;  // menu ID and category of each item on the menu
+    unsigned weights[3];                // customer : cashier : chef
+    unsigned seed;
+    int nextOrderId;
+    vector<vector<Category>> tickets;   // line categories of each order created so far
+    vector<bool> deleted;
+
+    unsigned random() {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 16) & 0x7fff;
+    }
+
+    // A created order that is still live, or 0 if there is none yet.
+    int liveOrder() {
+        if (tickets.empty()) return 0;
+        for (int tries = 0; tries < 8; ++tries) {
+            size_t slot = random() % tickets.size();
+            if (!deleted[slot]) return 1001 + static_cast<int>(slot);
+        }
+        return 0;
+    }
+
+    void quantity(ostringstream& in, Category category) {
+        const char* liters[] = {"0.5", "1", "1.5", "2"};
+        if (category == Category::Drink) {
+            in << liters[random() % 4] << "\n";
+        } else {
+            in << 1 + random() % 5 << "\n";
+        }
+    }
+
+    void createOrder(ostringstream& in) {
+        vector<Category> lines;
+        size_t count = 1 + random() % 3;
+        for (size_t i = 0; i < count && !items.empty(); ++i) {
+            const pair<int, Category>& item = items[random() % items.size()];
+            in << item.first << "\n";
+            quantity(in, item.second);
+            lines.push_back(item.second);
+        }
+        in << "0\n";
+        if (lines.empty()) return;
+        in << SESSION_CUSTOMERS[random() % 8] << "\n";
+        tickets.push_back(lines);
+        deleted.push_back(false);
+        nextOrderId++;
+    }
+
+    void updateOrder(ostringstream& in, int id) {
+        in << id << "\n";
+        const vector<Category>& lines = tickets[id - 1001];
+        size_t line = random() % lines.size();
+        if (lines.size() > 1) in << line + 1 << "\n";
+        quantity(in, lines[line]);
+    }
+
+    void customerAction(ostringstream& in) {
+        unsigned pick = random() % 100;
+        int id = liveOrder();
+        if (pick < 50 || id == 0) {
+            in << "1\n";
+            createOrder(in);
+        } else if (pick < 70) {
+            in << "2\n" << id << "\n";
+        } else if (pick < 80) {
+            in << "3\n";
+            updateOrder(in, id);
+        } else if (pick < 85) {
+            in << "4\n" << id << "\n";
+            deleted[id - 1001] = true;
+        } else {
+            const char* remarks[] = {"food was cold", "delivery was late", "great tibs", "too salty",
+                                     "friendly staff"};
+            in << "5\n" << id << "\n" << remarks[random() % 5] << "\n";
+        }
+    }
+
+    void cashierAction(ostringstream& in) {
+        unsigned pick = random() % 100;
+        int id = liveOrder();
+        if (pick < 30 || id == 0) {
+            in << "1\n";
+            createOrder(in);
+        } else if (pick < 36) {
+            in << "5\n" << id << "\n";
+        } else if (pick < 40) {
+            // Half the lookups are by a two-letter prefix.
+            string name = SESSION_CUSTOMERS[random() % 8];
+            in << "13\n" << (pick % 2 ? name : name.substr(0, 2)) << "\n";
+        } else if (pick < 48) {
+            in << "3\n";
+            updateOrder(in, id);
+        } else if (pick < 52) {
+            in << "4\n" << id << "\n";
+            deleted[id - 1001] = true;
+        } else if (pick < 60) {
+            in << "2\n";
+        } else if (pick < 66) {
+            in << "6\n";
+        } else if (pick < 78) {
+            in << "8\n";
+        } else if (pick < 86) {
+            in << "10\n00:00\n23:59\n";
+        } else if (pick < 92) {
+            in << "11\n" << currentDay() << "\n\n";
+        } else if (pick < 96 || items.empty()) {
+            in << "12\n";
+        } else {
+            const pair<int, Category>& item = items[random() % items.size()];
+            in << "7\n1\n" << item.first << "\n2\n" << 20 + random() % 100 << "0\n";
+        }
+    }
+
+    void chefAction(ostringstream& in) {
+        unsigned pick = random() % 100;
+        int id = liveOrder();
+        if (pick < 20) {
+            in << "1\n";
+        } else if (pick < 40) {
+            in << "4\n";
+        } else if (pick < 60 || id == 0) {
+            in << "6\n" << (pick % 2 ? "cold" : "late tibs") << "\n";
+        } else if (pick < 75) {
+            in << "5\n" << id << "\n";
+        } else {
+            in << "2\nc " << id << "\nr " << id << "\n0\n";
+        }
+    }
+
+    static string currentDay() {
+        time_t t = time(nullptr);
+        tm lt;
+        localtime_r(&t, &lt);
+        char buf[11];
+        strftime(buf, sizeof(buf), "%Y-%m-%d", &lt);
+        return string(buf);
+    }
+};
+
+// Sessions saved by --load-test --save: each starts with a "# session
+// <role>" line followed by its input lines.
+bool readSessions(const string& path, vector<ConsoleSession>& sessions) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    while (getline(in, line)) {
+        if (line.compare(0, 10, "# session ") == 0) {
+            ConsoleSession session;
+            string role = line.substr(10);
+            session.role = role == "cashier" ? 2 : role == "chef" ? 3 : 1;
+            sessions.push_back(session);
+        } else if (!sessions.empty()) {
+            sessions.back().input += line + "\n";
+        }
+    }
+    return true;
+}
+
+bool writeSessions(const string& path, const vector<ConsoleSession>& sessions) {
+    ofstream out(path);
+    for (const ConsoleSession& session : sessions) {
+        out << "# session " << SESSION_ROLES[session.role] << "\n" << session.input;
+    }
+    return static_cast<bool>(out);
+}
+
+// Runs console sessions through runConsole, the same prompt-driven code the
+// terminal uses, against a fresh store in a scratch directory, with cin fed
+// from each session's script and cout discarded. Sessions run back to back
+// (the console owns cin and cout); with a rate they start on an open-loop
+// schedule and latency counts from the scheduled start, so falling behind
+// shows up as queueing. Prints end-to-end session latency per role and the
+// overall session throughput.
+int runLoadTest(vector<ConsoleSession>& sessions, size_t count, const unsigned mix[3], unsigned seed,
+                double rate, const string& savePath) {
+    char dir[] = "/tmp/order-load-XXXXXX";
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd)) || !mkdtemp(dir) || chdir(dir) != 0) {
+        cout << "Cannot create a scratch directory for the load test.\n";
+        return 1;
+    }
+    setenv("ORDER_METRICS_INTERVAL", "0", 1);
+
+    NullBuffer nullBuffer;
+    streambuf* console = cout.rdbuf(&nullBuffer);
+    OrderManager* om = new OrderManager();
+    cout.rdbuf(console);
+
+    if (sessions.empty()) {
+        vector<pair<int, Category>> items;
+        string name;
+        Category category;
+        Money price;
+        for (int id = 1; id <= MAX_MENU_ID; ++id) {
+            if (om->menuItem(id, name, category, price)) items.push_back(make_pair(id, category));
+        }
+        SessionGenerator generator(items, mix, seed);
+        for (size_t i = 0; i < count; ++i) sessions.push_back(generator.next());
+    }
+    if (!savePath.empty()) {
+        string path = savePath[0] == '/' ? savePath : string(cwd) + "/" + savePath;
+        if (!writeSessions(path, sessions)) cout << "Cannot write " << path << ".\n";
+    }
+
+    vector<double> latency[4];
+    streambuf* input = cin.rdbuf();
+    cout.rdbuf(&nullBuffer);
+    auto started = chrono::steady_clock::now();
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        auto begin = chrono::steady_clock::now();
+        if (rate > 0) {
+            auto scheduled = started + chrono::duration_cast<chrono::steady_clock::duration>(
+                                           chrono::duration<double>(i / rate));
+            this_thread::sleep_until(scheduled);
+            begin = scheduled;
+        }
+        istringstream script(sessions[i].input);
+        cin.rdbuf(script.rdbuf());
+        cin.clear();
+        runConsole(*om);
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count();
+        latency[sessions[i].role].push_back(us);
+        latency[0].push_back(us);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    cin.rdbuf(input);
+    cin.clear();
+    delete om;
+    cout.rdbuf(console);
+
+    cout << left << setw(22) << "session" << right << setw(8) << "runs"
+         << setw(12) << "p50 (us)" << setw(12) << "p90 (us)" << setw(12) << "p99 (us)"
+         << setw(12) << "max (us)" << setw(14) << "sessions/sec" << "\n";
+    for (int role = 1; role <= 3; ++role) printLatency(SESSION_ROLES[role], latency[role]);
+    printLatency("all", latency[0]);
+    cout << sessions.size() << " session(s) in " << fixed << setprecision(2) << seconds << " s ("
+         << setprecision(0) << (seconds > 0 ? sessions.size() / seconds : 0.0) << " sessions/sec).\n";
+
+    if (chdir(cwd) != 0) return 1;
+    nftw(dir, removeBenchFile, 16, FTW_DEPTH | FTW_PHYS);
+    return 0;
+}
+
+// Checks what a failed journal or feedback-log write leaves behind,
+// against a fresh store in a scratch directory under /tmp. With the log
+// broken the change must still succeed through a snapshot; with the
+// snapshot blocked too it must stay in the store exactly once, reported as
+// not saved rather than refused. The store is then reopened to check what
+// reached disk. Prints one line per check; returns 1 if any failed.
+int runFaultTest() {
+    char dir[] = "/tmp/order-fault-XXXXXX";
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd)) || !mkdtemp(dir) || chdir(dir) != 0) {
+        cout << "Cannot create a scratch directory for the fault test.\n";
+        return 1;
+    }
+    setenv("ORDER_METRICS_INTERVAL", "0", 1);
+
+    int failures = 0;
+    auto check = [&failures](bool passed, const string& what) {
+        cout << (passed ? "ok    " : "FAIL  ") << what << "\n";
+        if (!passed) failures++;
+    };
+    NullBuffer nullBuffer;
+    streambuf* console = cout.rdbuf(&nullBuffer);
+    OrderManager* om = new OrderManager();
+    vector<pair<int, Quantity>> items(1, make_pair(1, 2 * QUANTITY_ONE));
+    Order first, second, third, unsaved, found;
+    vector<string> names;
+    string error, day, saveError;
+    int placedToday = 0, reloadedToday = 0;
+    Money revenue;
+
+    bool placed = om->placeOrder(items, "Abebe", first, error);
+    bool broken = om->breakLog(false);
+    bool recovered = om->placeOrder(items, "Sara", second, error);
+    bool healthy = om->placeOrder(items, "Hana", third, error);
+    om->breakLog(false);
+    bool blocked = mkdir("orders.bin.tmp", 0755) == 0;
+    bool refused = !om->placeOrder(items, "Dawit", unsaved, saveError);
+    bool kept = om->lookupOrder(unsaved.id, found, names);
+    om->todaySales(day, placedToday, revenue);
+    rmdir("orders.bin.tmp");
+    bool cancelled = om->cancelOrder(first.id, error);
+
+    vector<OrderRequest> batch(2);
+    for (OrderRequest& req : batch) {
+        req.items = items;
+        req.customer = "Meron";
+        req.line = 0;
+    }
+    vector<pair<int, string>> rejected;
+    string batchError;
+    om->breakLog(false);
+    size_t batchAccepted = om->placeOrders(batch, rejected, &batchError);
+
+    om->breakLog(true);
+    bool feedbackSaved = om->addFeedback(second.id, "Too salty", error);
+    bool feedbackAfter = om->addFeedback(third.id, "Great", error);
+    size_t feedbackKept = om->feedbackFor(second.id).size();
+    int nextExpected = unsaved.id + 3;
+
+    delete om;
+    om = new OrderManager();
+    Order after;
+    bool reloaded = om->lookupOrder(second.id, found, names) && om->lookupOrder(third.id, found, names) &&
+                    om->lookupOrder(unsaved.id, found, names);
+    bool deleted = om->lookupOrder(first.id, found, names) && found.status == OrderStatus::Deleted;
+    om->todaySales(day, reloadedToday, revenue);
+    om->placeOrder(items, "Yonas", after, error);
+    size_t feedbackReloaded = om->feedbackFor(second.id).size() + om->feedbackFor(third.id).size();
+    delete om;
+    cout.rdbuf(console);
+
+    check(placed && broken, "store opens and the journal can be broken");
+    check(recovered, "order placed with the journal failing is saved through a snapshot");
+    check(healthy, "journal takes writes again after the snapshot");
+    check(blocked && refused && saveError.find("Order " + to_string(unsaved.id)) == 0,
+          "order that cannot be saved at all is reported with its ID");
+    check(kept && placedToday == 4, "that order stays in the store exactly once");
+    check(cancelled, "next change saves everything once the snapshot can be written");
+    check(batchAccepted == 2 && rejected.empty() && batchError.empty(),
+          "batch placed with the journal failing is saved, not rejected");
+    check(feedbackSaved && feedbackAfter && feedbackKept == 1,
+          "feedback is saved through a rewrite and the log recovers");
+    check(reloaded && deleted, "orders and the cancellation survive a restart");
+    check(reloadedToday == 5 && after.id == nextExpected, "no order is lost or duplicated on restart");
+    check(feedbackReloaded == 2, "feedback survives a restart");
+
+    if (chdir(cwd) != 0) return 1;
+    nftw(dir, removeBenchFile, 16, FTW_DEPTH | FTW_PHYS);
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    string cmd = argc >= 2 ? argv[1] : "";
+    if (cmd == "--bench") {
+        long maxOrders = argc >= 3 ? atol(argv[2]) : 1000000;
+        return runBenchmark(maxOrders > 0 ? static_cast<size_t>(maxOrders) : 1000000);
+    }
+    if (cmd == "--fault-test") return runFaultTest();
+    if (cmd == "--load-test") {
+        long count = 1000;
+        unsigned mix[3] = {70, 20, 10};
+        unsigned seed = 12345;
+        double rate = 0;
+        string savePath, replayPath;
+        bool valid = true;
+        for (int i = 2; i < argc && valid; ++i) {
+            string flag = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (flag == "--mix" && hasValue) {
+                valid = sscanf(argv[++i], "%u:%u:%u", &mix[0], &mix[1], &mix[2]) == 3 &&
+                        mix[0] + mix[1] + mix[2] > 0;
+            } else if (flag == "--rate" && hasValue) {
+                rate = atof(argv[++i]);
+            } else if (flag == "--seed" && hasValue) {
+                seed = static_cast<unsigned>(atol(argv[++i]));
+            } else if (flag == "--save" && hasValue) {
+                savePath = argv[++i];
+            } else if (flag == "--replay" && hasValue) {
+                replayPath = argv[++i];
+            } else {
+                count = atol(argv[i]);
+                valid = count > 0;
+            }
+        }
+        vector<ConsoleSession> sessions;
+        if (valid && !replayPath.empty()) {
+            valid = readSessions(replayPath, sessions) && !sessions.empty();
+        }
+        if (!valid || rate < 0) {
+            cout << "Usage: " << argv[0] << " --load-test [sessions] [--mix customer:cashier:chef]"
+                 << " [--rate sessions/sec] [--seed N] [--save file] [--replay file]\n";
+            return 1;
+        }
+        return runLoadTest(sessions, static_cast<size_t>(count), mix, seed, rate, savePath);
+    }
+    // Without a terminal the server runs until SIGINT/SIGTERM. Block them
+    // before OrderManager starts its flusher and metrics threads, which
+    // inherit the mask, so only sigwait sees them.
+    bool console = isatty(STDIN_FILENO);
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    if (cmd == "--serve" && !console) pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    OrderManager sharedOM;
+    if (cmd == "--export-csv" || cmd == "--import-csv") {
+        string path = argc >= 3 ? argv[2] : "orders.txt";
+        if (cmd == "--export-csv") return sharedOM.exportOrders(path) ? 0 : 1;
+        return sharedOM.importOrders(path) ? 0 : 1;
+    }
+    if (cmd == "--list-orders") {
+        bool sorted = false;
+        long page = 0, limit = static_cast<long>(LIST_PAGE_ROWS);
+        for (int i = 2; i < argc; ++i) {
+            string flag = argv[i];
+            if (flag == "--sorted") {
+                sorted = true;
+            } else if (flag == "--page" && i + 1 < argc) {
+                page = atol(argv[++i]);
+            } else if (flag == "--limit" && i + 1 < argc) {
+                limit = atol(argv[++i]);
+            } else {
+                page = -1;
+            }
+        }
+        if (page < 0 || limit <= 0) {
+            cout << "Usage: " << argv[0] << " --list-orders [--sorted] [--page N] [--limit N]\n";
+            return 1;
+        }
+        sharedOM.listOrderPages(sorted, static_cast<size_t>(page), static_cast<size_t>(limit), false);
+        return 0;
+    }
+    if (cmd == "--sales-report") {
+        int64_t from, to;
+        string fromDay = argc >= 3 ? argv[2] : "";
+        string toDay = argc >= 4 ? argv[3] : fromDay;
+        if (!parseTime(fromDay + " 00:00", from) || !parseTime(toDay + " 00:00", to) || to < from) {
+            cout << "Usage: " << argv[0] << " --sales-report <from YYYY-MM-DD> [to YYYY-MM-DD] [top K]\n";
+            return 1;
+        }
+        long topK = argc >= 5 ? atol(argv[4]) : 10;
+        sharedOM.printSalesReport(fromDay, toDay, from, startOfDay(to + 26 * 3600),
+                                  topK > 0 ? static_cast<size_t>(topK) : 10);
+        return 0;
+    }
+    if (cmd == "--import-orders") {
+        if (argc < 3) {
+            cout << "Usage: " << argv[0] << " --import-orders <file|-> [batch size]\n";
+            return 1;
+        }
+        long batchSize = argc >= 4 ? atol(argv[3]) : 1000;
+        return runBatchImport(sharedOM, argv[2], batchSize > 0 ? static_cast<size_t>(batchSize) : 1000);
+    }
+    if (cmd == "--serve") {
+        OrderServer server(sharedOM, argc >= 3 ? argv[2] : "orders.sock");
+        if (!server.start()) return 1;
+        if (console) {
+            runConsole(sharedOM);
+        } else {
+            int sig;
+            sigwait(&stopSignals, &sig);
+        }
+        server.stop();
+        cout << "Goodbye!\n";
+        return 0;
+    }
+    if (!cmd.empty()) {
+        cout << "Usage: " << argv[0]
+             << " [--export-csv [file] | --import-csv [file] | --import-orders <file|-> [batch size]"
+             << " | --list-orders [--sorted] [--page N] [--limit N] | --sales-report <from> [to] [top K]"
+             << " | --serve [socket] | --bench [max orders] | --load-test [sessions] [options] | --fault-test]\n";
+        return 1;
+    }
+    runConsole(sharedOM);
     cout << "Goodbye!\n";
     return 0;
 }